@@ -25,7 +25,8 @@ public:
     MappedAdd add;
     uint64_t issueTime = 0ul;
     uint64_t finishTime = 0ul;
-    unsigned int data[16];
+    alignas(64) unsigned int data[16];
+    bool hasData = false;   // Whether data was read from the trace for this command
     Command() = default;
 
     Command(CommandType cmdType, const MappedAdd add, uint64_t issueTime, uint64_t finishTime, unsigned int data[16]);
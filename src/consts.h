@@ -13,6 +13,7 @@ Released under the MIT License
 #ifndef VAMPIRE_CONSTS_H
 #define VAMPIRE_CONSTS_H
 
+#include <cstdint>
 #include <string>
 
 //#define DEBUG
@@ -35,6 +36,11 @@ static const std::string DARKBLUE = "\033[1m\033[40m";
 #define LATENCY_REFRESH 10
 #define LATENCY_STATIC   5
 static const int BURST_LENGTH = 8; // TODO: make more generalized and read from config
+static const size_t PARSE_BATCH_SIZE = 256; // # of commands decoded by a parser at once
+static const int PARSE_SPIN = 64; // # of times a parsing thread polls its ring before sleeping on it
+static const size_t PARSE_CHUNK_SIZE = 1 << 20; // Bytes of an ASCII trace parsed by a worker thread at once
+static const uint64_t TRACE_INDEX_INTERVAL = 1 << 16; // # of commands between the checkpoints of a trace index
+static const std::string TRACE_STDIN = "-"; // Trace file name that reads the trace from the standard input
 
 /* Macros */
 #define FUNCTION_STR std::string(__FUNCTION__)
@@ -61,8 +67,9 @@ enum class StructVar        {NO, YES, MAX};
 enum class TraceType        {MEAN, DIST, WR, RD_WR, MAX};
 enum class Level            {CHANNEL, RANK, BANK, ROW, COLUMN, MAX};
 enum class State            {OPEN, CLOSE, MAX};
-enum class CmdInterleaving  {BANK, NONE, MAX};                          // Interleaving for RD/WR commands
-enum class ParserType       {BINARY, ASCII, MAX};
+enum class CmdInterleaving  {BANK, BANK_COL, COL, NONE, MAX};          // Interleaving of a RD/WR with the previous one
+enum class ParserType       {BINARY, ASCII, RAMULATOR, DRAMSIM3, DRAMPOWER, MAX};
+enum class MemImageType     {SPARSE, FLAT, DEDUP, COMPRESSED, MAX};                        // Backing store of the memory contents (WR)
 
 const std::string commandString[int(CommandType::MAX)] = {
         "ACT", "PRE", "PREA",
@@ -75,7 +82,9 @@ const std::string encodingString[]      = {"NONE", "BDI", "CUSTOM", "CUSTOM_ADV"
 const std::string vendorString[]        = {"A", "B", "C", "Cust"};
 const std::string structVarString[]     = {"NO", "YES"};
 const std::string traceTypeString[]     = {"MEAN", "DIST", "WR", "RD_WR"};
-const std::string parserTypeString[]    = {"BINARY", "ASCII"};
+const std::string parserTypeString[]    = {"BINARY", "ASCII", "RAMULATOR", "DRAMSIM3", "DRAMPOWER"};
+const std::string memImageTypeString[]  = {"SPARSE", "FLAT", "DEDUP", "COMPRESSED"};
+const std::string cmdInterleavingString[] = {"BANK", "BANK_COL", "COL", "NONE"};
 
 /* Constant values for parsing config file */
 static const std::string VENDOR_STR = "vendor";
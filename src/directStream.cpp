@@ -0,0 +1,328 @@
+/*
+
+DIRECTSTREAM.CPP
+
+VAMPIRE: Variation-Aware model of Memory Power Informed by Real Experiments
+https://github.com/CMU-SAFARI/VAMPIRE
+
+Copyright (c) SAFARI Research Group at Carnegie Mellon University and ETH Zürich
+Released under the MIT License
+
+*/
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#ifdef HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+#include "helper.h"
+#include "directStream.h"
+
+/* Submission and completion rings shared with the kernel, set up through the raw system calls so that no library is
+ * needed. The estimation thread is the only producer and consumer of both rings */
+#ifdef HAVE_IO_URING
+struct DirectStream::Uring {
+    int fd = -1;
+    io_uring_params params = {};
+    void *sqRing = MAP_FAILED, *cqRing = MAP_FAILED;
+    size_t sqRingSize = 0, cqRingSize = 0;
+    io_uring_sqe *sqes = (io_uring_sqe *) MAP_FAILED;
+    size_t sqesSize = 0;
+
+    unsigned *sqTail = nullptr, *sqMask = nullptr, *sqArray = nullptr;
+    unsigned *cqHead = nullptr, *cqTail = nullptr, *cqMask = nullptr;
+    io_uring_cqe *cqes = nullptr;
+
+    iovec iovecs[DEPTH];                // One per slot
+    unsigned pending = 0;               // # of reads queued but not submitted yet
+    unsigned inFlight = 0;              // # of reads submitted but not completed yet
+
+    ~Uring() {
+        if (sqes != MAP_FAILED)
+            munmap(sqes, sqesSize);
+        if (cqRing != MAP_FAILED && cqRing != sqRing)
+            munmap(cqRing, cqRingSize);
+        if (sqRing != MAP_FAILED)
+            munmap(sqRing, sqRingSize);
+        if (fd >= 0)
+            close(fd);
+    }
+};
+#else
+struct DirectStream::Uring {
+    unsigned inFlight = 0;
+};
+#endif
+
+/************************/
+/* Class : DirectStream */
+/************************/
+DirectStream::DirectStream(const std::string &filename) : filename(filename), slots(DEPTH) {
+    for (auto &slot : slots) {
+        void *data = nullptr;
+        msg::error(posix_memalign(&data, ALIGNMENT, READ_SIZE) != 0, "Unable to allocate the trace read buffers.");
+        slot.data = (uint8_t *) data;
+    }
+
+    // Some file systems accept O_DIRECT when opening but reject the reads, probe them with the first block
+    fd = ::open(filename.c_str(), O_RDONLY | O_DIRECT);
+    if (fd >= 0 && pread(fd, slots[0].data, ALIGNMENT, 0) < 0 && errno == EINVAL) {
+        close(fd);
+        fd = -1;
+    }
+    isDirect = fd >= 0;
+    if (!isDirect)
+        fd = ::open(filename.c_str(), O_RDONLY);
+
+    struct stat fileStat = {};
+    msg::error(fd < 0 || fstat(fd, &fileStat) != 0, "Unable to open trace file `" + filename + "'.");
+    fileSize = (uint64_t) fileStat.st_size;
+    blockCount = (fileSize + READ_SIZE - 1) / READ_SIZE;
+    if (!isDirect)
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    if (uring_setup()) {
+        while (issued < std::min<uint64_t>(uint64_t(DEPTH), blockCount)) {
+            uring_submit(issued++);
+        }
+        uring_reap(false);
+    } else {
+        for (size_t reader = 0; reader < READER_THREADS; reader++) {
+            readers.emplace_back(&DirectStream::reader_loop, this);
+        }
+    }
+}
+
+DirectStream::~DirectStream() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stop = true;
+    }
+    slotFreed.notify_all();
+    for (auto &reader : readers) {
+        reader.join();
+    }
+
+    // The kernel may still be writing to the buffers
+    while (uring != nullptr && uring->inFlight > 0) {
+        uring_reap(true);
+    }
+    delete uring;
+
+    for (auto &slot : slots) {
+        free(slot.data);
+    }
+    if (fd >= 0)
+        close(fd);
+}
+
+std::string DirectStream::engine() const {
+    return std::string(uring != nullptr ? "io_uring" : "pread threads")
+           + (isDirect ? " and O_DIRECT" : ", dropping the trace from the page cache");
+}
+
+/* Completes the read of block into slot from its first `done' bytes */
+void DirectStream::read_block(uint64_t block, Slot &slot, size_t done) {
+    uint64_t offset = block * READ_SIZE;
+    size_t size = (size_t) std::min<uint64_t>(uint64_t(READ_SIZE), fileSize - offset);
+    size_t request = isDirect ? (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT : size;
+
+    while (done < size) {
+        ssize_t bytes = pread(fd, slot.data + done, request - done, offset + done);
+        if (bytes < 0 && errno == EINTR)
+            continue;
+        msg::error(bytes < 0, "Unable to read trace file `" + filename + "': " + strerror(errno));
+        if (bytes == 0)
+            break; // The trace was truncated while it was read
+        done += bytes;
+    }
+    slot.size = std::min(done, size);
+
+    if (!isDirect)
+        posix_fadvise(fd, offset, size, POSIX_FADV_DONTNEED);
+}
+
+/* Body of the reader threads, which read the blocks in order as their slots are freed */
+void DirectStream::reader_loop() {
+    std::unique_lock<std::mutex> guard(lock);
+
+    while (true) {
+        slotFreed.wait(guard, [this] {return stop || issued >= blockCount || issued < released + DEPTH;});
+        if (stop || issued >= blockCount)
+            return;
+
+        uint64_t block = issued++;
+        Slot &slot = slots[block % DEPTH];
+        guard.unlock();
+        read_block(block, slot, 0);
+        guard.lock();
+
+        slot.block = block;
+        slot.ready = true;
+        slotReady.notify_all();
+    }
+}
+
+DirectStream::Slot &DirectStream::wait_current() {
+    Slot &slot = slots[current % DEPTH];
+    if (uring != nullptr) {
+        while (!(slot.ready && slot.block == current)) {
+            uring_reap(true);
+        }
+    } else {
+        std::unique_lock<std::mutex> guard(lock);
+        slotReady.wait(guard, [this, &slot] {return slot.ready && slot.block == current;});
+    }
+    return slot;
+}
+
+void DirectStream::release_current() {
+    Slot &slot = slots[current % DEPTH];
+    current++;
+    currentPos = 0;
+
+    if (uring != nullptr) {
+        slot.ready = false;
+        if (issued < blockCount)
+            uring_submit(issued++);
+        uring_reap(false);
+    } else {
+        std::lock_guard<std::mutex> guard(lock);
+        slot.ready = false;
+        released++;
+        slotFreed.notify_all();
+    }
+}
+
+size_t DirectStream::read(uint8_t *buf, size_t size) {
+    size_t total = 0;
+
+    while (total < size && current < blockCount) {
+        // The slot is only waited for at the start of a block, it stays ready until it is released
+        Slot &slot = (currentPos == 0) ? wait_current() : slots[current % DEPTH];
+        size_t bytes = std::min(size - total, slot.size - currentPos);
+        memcpy(buf + total, slot.data + currentPos, bytes);
+        total += bytes;
+        currentPos += bytes;
+
+        if (currentPos == slot.size)
+            release_current();
+    }
+    return total;
+}
+
+#ifdef HAVE_IO_URING
+bool DirectStream::uring_setup() {
+    auto *ring = new Uring();
+    auto &params = ring->params;
+
+    ring->fd = (int) syscall(__NR_io_uring_setup, DEPTH, &params);
+    if (ring->fd < 0) {
+        delete ring;
+        return false;
+    }
+
+    ring->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMmap)
+        ring->sqRingSize = ring->cqRingSize = std::max(ring->sqRingSize, ring->cqRingSize);
+
+    ring->sqRing = mmap(nullptr, ring->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd,
+                        IORING_OFF_SQ_RING);
+    ring->cqRing = singleMmap ? ring->sqRing : mmap(nullptr, ring->cqRingSize, PROT_READ | PROT_WRITE,
+                                                    MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+    ring->sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    ring->sqes = (io_uring_sqe *) mmap(nullptr, ring->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                       ring->fd, IORING_OFF_SQES);
+    if (ring->sqRing == MAP_FAILED || ring->cqRing == MAP_FAILED || ring->sqes == MAP_FAILED) {
+        delete ring;
+        return false;
+    }
+
+    auto *sq = (uint8_t *) ring->sqRing;
+    auto *cq = (uint8_t *) ring->cqRing;
+    ring->sqTail  = (unsigned *) (sq + params.sq_off.tail);
+    ring->sqMask  = (unsigned *) (sq + params.sq_off.ring_mask);
+    ring->sqArray = (unsigned *) (sq + params.sq_off.array);
+    ring->cqHead  = (unsigned *) (cq + params.cq_off.head);
+    ring->cqTail  = (unsigned *) (cq + params.cq_off.tail);
+    ring->cqMask  = (unsigned *) (cq + params.cq_off.ring_mask);
+    ring->cqes    = (io_uring_cqe *) (cq + params.cq_off.cqes);
+
+    uring = ring;
+    return true;
+}
+
+void DirectStream::uring_submit(uint64_t block) {
+    uint64_t offset = block * READ_SIZE;
+    size_t size = (size_t) std::min<uint64_t>(uint64_t(READ_SIZE), fileSize - offset);
+    iovec &iov = uring->iovecs[block % DEPTH];
+    iov.iov_base = slots[block % DEPTH].data;
+    iov.iov_len = isDirect ? (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT : size;
+
+    unsigned tail = *uring->sqTail;
+    unsigned index = tail & *uring->sqMask;
+    io_uring_sqe &sqe = uring->sqes[index];
+    memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = IORING_OP_READV;
+    sqe.fd = fd;
+    sqe.off = offset;
+    sqe.addr = (uint64_t) &iov;
+    sqe.len = 1;
+    sqe.user_data = block;
+
+    uring->sqArray[index] = index;
+    __atomic_store_n(uring->sqTail, tail + 1, __ATOMIC_RELEASE);
+    uring->pending++;
+    uring->inFlight++;
+}
+
+/* Submits the queued reads and collects the completed ones, waiting for one if wait is set and none is there */
+void DirectStream::uring_reap(bool wait) {
+    unsigned head = *uring->cqHead;
+    bool isEmpty = head == __atomic_load_n(uring->cqTail, __ATOMIC_ACQUIRE);
+
+    if (uring->pending > 0 || (wait && isEmpty)) {
+        unsigned waitFor = (wait && isEmpty) ? 1 : 0;
+        int submitted = (int) syscall(__NR_io_uring_enter, uring->fd, uring->pending, waitFor,
+                                      waitFor ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+        if (submitted < 0 && errno == EINTR)
+            return;
+        msg::error(submitted < 0, "Unable to read trace file `" + filename + "': " + strerror(errno));
+        uring->pending -= (unsigned) submitted;
+    }
+
+    while (head != __atomic_load_n(uring->cqTail, __ATOMIC_ACQUIRE)) {
+        const io_uring_cqe &cqe = uring->cqes[head & *uring->cqMask];
+        uint64_t block = cqe.user_data;
+        Slot &slot = slots[block % DEPTH];
+        msg::error(cqe.res < 0, "Unable to read trace file `" + filename + "': " + strerror(-cqe.res));
+
+        // Short reads are completed synchronously
+        read_block(block, slot, (size_t) cqe.res);
+        slot.block = block;
+        slot.ready = true;
+        uring->inFlight--;
+        head++;
+    }
+    __atomic_store_n(uring->cqHead, head, __ATOMIC_RELEASE);
+}
+#else
+bool DirectStream::uring_setup() {
+    return false;
+}
+
+void DirectStream::uring_submit(uint64_t block) {}
+
+void DirectStream::uring_reap(bool wait) {}
+#endif
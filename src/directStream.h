@@ -0,0 +1,87 @@
+/*
+
+DIRECTSTREAM.H
+
+VAMPIRE: Variation-Aware model of Memory Power Informed by Real Experiments
+https://github.com/CMU-SAFARI/VAMPIRE
+
+Copyright (c) SAFARI Research Group at Carnegie Mellon University and ETH Zürich
+Released under the MIT License
+
+*/
+
+#ifndef VAMPIRE_DIRECTSTREAM_H
+#define VAMPIRE_DIRECTSTREAM_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "traceStream.h"
+
+/*
+ * Reads a trace file in large aligned blocks that bypass the page cache (O_DIRECT), for traces that do not fit in it.
+ * Up to DEPTH blocks are read ahead into a ring of buffers, through io_uring when VAMPIRE is built with it and the
+ * kernel allows it, else by reader threads issuing pread(). On file systems without O_DIRECT the blocks are read
+ * through the page cache and dropped from it once consumed.
+ */
+class DirectStream : public TraceStream {
+private:
+    static const size_t READ_SIZE = 4 << 20;        // Bytes per read, a multiple of any logical block size
+    static const size_t DEPTH = 8;                  // # of blocks read ahead
+    static const size_t ALIGNMENT = 4096;
+    static const size_t READER_THREADS = 2;
+
+    struct Slot {
+        uint8_t *data = nullptr;
+        uint64_t block = UINT64_MAX;                // Block held by the slot once ready
+        size_t size = 0;                            // # of bytes read
+        bool ready = false;
+    };
+
+    std::string filename;
+    int fd = -1;
+    bool isDirect = false;                          // The file is read with O_DIRECT
+    uint64_t fileSize = 0;
+    uint64_t blockCount = 0;
+
+    std::vector<Slot> slots;
+    uint64_t current = 0;                           // Block being consumed
+    size_t currentPos = 0;                          // Next byte to hand out from the current block
+
+    // Reader threads, protected by lock
+    std::mutex lock;
+    std::condition_variable slotReady, slotFreed;
+    std::vector<std::thread> readers;
+    uint64_t issued = 0;                            // # of blocks claimed by a reader
+    uint64_t released = 0;                          // # of blocks consumed
+    bool stop = false;
+
+    struct Uring;
+    Uring *uring = nullptr;                         // nullptr when the blocks are read by the reader threads
+
+    /* Reads block into slot, of which the first `done' bytes are already read, exits on I/O errors */
+    void read_block(uint64_t block, Slot &slot, size_t done);
+    void reader_loop();
+    /* Waits until the current block is in its slot */
+    Slot &wait_current();
+    /* Hands the slot of the current block back for block current + DEPTH */
+    void release_current();
+
+    bool uring_setup();
+    void uring_submit(uint64_t block);
+    void uring_reap(bool wait);
+public:
+    /* Opens filename, exits if it cannot be read */
+    explicit DirectStream(const std::string &filename);
+    ~DirectStream() override;
+    size_t read(uint8_t *buf, size_t size) override;
+
+    /* Name of the engine reading the blocks, for messages */
+    std::string engine() const;
+};
+
+#endif //VAMPIRE_DIRECTSTREAM_H
@@ -10,6 +10,7 @@ Released under the MIT License
 
 */
 
+#include <cstring>
 #include <iostream>
 #include "dramSpec.h"
 
@@ -26,6 +27,10 @@ std::vector<double_t> &DramSpec::getCmdCurrent() {
     return *this->cmdCurrent_ptr;
 }
 
+void DramSpec::set_io_currents(VendorType vendorType) {
+    memcpy(ioCurrent, IO_CURRENTS[int(vendorType)], sizeof(ioCurrent));
+}
+
 DramSpec_A::DramSpec_A() : DramSpec() {
     auto &cmdLength = *cmdLength_ptr;
     auto &cmdCurrent = *cmdCurrent_ptr;
@@ -55,6 +60,8 @@ DramSpec_A::DramSpec_A() : DramSpec() {
 
     actStandbyEnergy = 129.3598;
     preStandbyEnergy = 119.0111;
+
+    set_io_currents(VendorType::A);
 }
 
 DramSpec_B::DramSpec_B() : DramSpec() {
@@ -86,6 +93,8 @@ DramSpec_B::DramSpec_B() : DramSpec() {
 
     actStandbyEnergy = 161.6844;
     preStandbyEnergy = 181.3352;
+
+    set_io_currents(VendorType::B);
 }
 
 DramSpec_C::DramSpec_C() : DramSpec() {
@@ -117,6 +126,8 @@ DramSpec_C::DramSpec_C() : DramSpec() {
 
     actStandbyEnergy = 112.6297;
     preStandbyEnergy = 122.75881;
+
+    set_io_currents(VendorType::C);
 }
 
 DramSpec_Cust::DramSpec_Cust(const std::string &fname) : DramSpec() {
@@ -131,6 +142,8 @@ DramSpec_Cust::DramSpec_Cust(const std::string &fname) : DramSpec() {
         cmdCurrent[i] = 0;
     }
 
+    set_io_currents(VendorType::Cust);
+
     /* Start parsing the dramSpec file */
     std::ifstream file(fname);
 
@@ -212,6 +225,31 @@ DramSpec_Cust::DramSpec_Cust(const std::string &fname) : DramSpec() {
             lineParsed = true;
         }
 
+        // Parse the coefficients of the RD/WR currents, e.g. currentSlope.RD.BANK_COL
+        std::vector<std::string> keyTokens = Helper::splitStr(tokens[0], '.');
+        if (keyTokens[0] == "currentIntercept" || keyTokens[0] == "currentSlope" || keyTokens[0] == "currentToggleSlope") {
+            int cmdLoc = -1, interleavingLoc = -1;
+            if (keyTokens.size() == 3) {
+                cmdLoc = Helper::findInArr<std::string>(&commandString[0], keyTokens[1], int(CommandType::MAX));
+                interleavingLoc = Helper::findInArr<std::string>(&cmdInterleavingString[0], keyTokens[2],
+                                                                 int(CmdInterleaving::MAX));
+            }
+
+            if ((cmdLoc != int(CommandType::RD) && cmdLoc != int(CommandType::WR)) || interleavingLoc == -1) {
+                msg::error("DramSpec: Unable to parse `" + origLine + "', expected " + keyTokens[0]
+                           + ".{RD|WR}.{BANK|BANK_COL|COL|NONE}.");
+            }
+
+            auto &current = ioCurrent[io_command(CommandType(cmdLoc))][interleavingLoc];
+            if (keyTokens[0] == "currentIntercept")
+                current.intercept = std::stof(tokens[1]);
+            else if (keyTokens[0] == "currentSlope")
+                current.slope = std::stof(tokens[1]);
+            else
+                current.toggleSlope = std::stof(tokens[1]);
+            lineParsed = true;
+        }
+
         if (tokens[0] == "actCmdEnergy") {
             actCmdEnergy = std::stod(tokens[1]);
             lineParsed = true;
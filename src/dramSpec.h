@@ -21,6 +21,46 @@ Released under the MIT License
 #include "consts.h"
 #include "helper.h"
 
+/*
+ * Coefficients of the current (mA) of a RD/WR as a function of the # of set and toggled bits of its line:
+ * intercept + setBits/8 * slope + toggledBits/8 * toggleSlope
+ */
+struct IoCurrent {
+    float intercept;
+    float slope;
+    float toggleSlope;
+};
+
+/* Index of a RD/WR in the tables of IoCurrent */
+inline int io_command(CommandType type) {
+    return type == CommandType::WR ? 1 : 0;
+}
+
+static const int IO_COMMANDS = 2;   // RD, WR
+
+/*
+ * IoCurrent of each vendor for RD/WR commands by their interleaving with the previous RD/WR. Cust vendors start from the
+ * intercepts and slopes of vendor C without toggle currents, their dramSpec file can set any of them.
+ */
+constexpr IoCurrent IO_CURRENTS[int(VendorType::MAX)][IO_COMMANDS][int(CmdInterleaving::MAX)] = {
+        {   /* A:  BANK                       BANK_COL                   COL                        NONE */
+                {{287.235f,  5.035f, 0.160f}, {277.128f,  5.219f, 0.160f}, {246.440f,  6.558f, 0.431f}, {250.879f,  6.679f, 0.0f}},
+                {{732.500f, -5.079f, 0.180f}, {735.149f, -5.082f, 0.180f}, {728.750f, -5.056f, 0.712f}, {687.178f, -4.820f, 0.0f}}
+        },
+        {   /* B */
+                {{228.142f,  4.358f, 0.291f}, {223.613f,  4.302f, 0.291f}, {217.420f,  4.342f, 0.548f}, {226.689f,  4.400f, 0.0f}},
+                {{617.553f, -4.517f, 0.062f}, {618.0f,   -4.521f, 0.062f}, {664.403f, -4.810f, 0.204f}, {645.515f, -4.613f, 0.0f}}
+        },
+        {   /* C */
+                {{289.992f,  3.360f, 0.364f}, {266.511f,  3.877f, 0.364f}, {234.417f,  4.321f, 0.693f}, {222.114f,  4.155f, 0.0f}},
+                {{501.901f, -3.516f, 0.072f}, {520.791f, -3.661f, 0.072f}, {565.860f, -4.012f, 0.259f}, {540.974f, -3.807f, 0.0f}}
+        },
+        {   /* Cust */
+                {{289.992f,  3.360f, 0.0f},   {266.511f,  3.877f, 0.0f},   {234.417f,  4.321f, 0.0f},   {222.114f,  4.155f, 0.0f}},
+                {{501.901f, -3.516f, 0.0f},   {520.791f, -3.661f, 0.0f},   {565.860f, -4.012f, 0.0f},   {540.974f, -3.807f, 0.0f}}
+        }
+};
+
 class DramSpec {
 private:
 protected:
@@ -47,6 +87,9 @@ public:
     double_t preCmdEnergy = 0;
     double_t actStandbyEnergy = 0;
     double_t preStandbyEnergy = 0;
+
+    IoCurrent ioCurrent[IO_COMMANDS][int(CmdInterleaving::MAX)];   // IO_CURRENTS of the vendor, set by Cust vendors
+    void set_io_currents(VendorType vendorType);
 };
 
 class DramSpec_A : public DramSpec {
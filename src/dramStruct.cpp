@@ -89,18 +89,25 @@ bool DramStruct::isBankActive(uint64_t &bankNum) {
     return true; // Todo: Implement this
 }
 
-DramStruct::DramStruct() {
-    this->bankStates = new std::vector<State>(8, State::CLOSE);
-    this->banks = new std::vector<Bank*>(8);
-    for (auto &bank : *banks) {
-        bank = new Bank(0, 0);
-    }
+void DramStruct::setBankState(uint64_t bankNum, State state) {
+    State &bankState = bankStates[bankNum];
+    if (bankState == state)
+        return;
+
+    if (state == State::OPEN)
+        rankOf(bankNum).openBankCount++;
+    else
+        rankOf(bankNum).openBankCount--;
+    bankState = state;
 }
 
-DramStruct::~DramStruct() {
-    for (auto bank : *banks) {
-        delete bank;
+DramStruct::DramStruct(Config &configs)
+        : rankCount(configs.getNumRanks()), bankCount(configs.getNumBanks()) {
+    ranks.resize(configs.getNumChannels() * rankCount);
+    for (uint64_t rank = 0; rank < ranks.size(); rank++) {
+        ranks[rank].channel = rank / rankCount;
+        ranks[rank].rank = rank % rankCount;
     }
-    delete banks;
-    delete bankStates;
-}
\ No newline at end of file
+    banks.resize(ranks.size() * bankCount, Bank(0, 0));
+    bankStates.resize(banks.size(), State::CLOSE);
+}
@@ -18,6 +18,7 @@ Released under the MIT License
 #include <algorithm>
 #include <cmath>
 
+#include "address.h"
 #include "consts.h"
 #include "config.h"
 
@@ -50,8 +51,8 @@ public:
 
 class DramStruct {
 public:
-    DramStruct();
-    ~DramStruct();
+    explicit DramStruct(Config &configs);
+    ~DramStruct() = default;
     std::vector<Node*> *structure;
     bool isBankActive(uint64_t &bankNum);
     int init_struct_at_level(Node *node, int level, uint64_t *structCount);
@@ -63,10 +64,33 @@ public:
         uint64_t cmdEndTime = 0ul;
         uint64_t actRowNum = 0ul;
     };
+    class Rank {
+    public:
+        // Standby before the first command of the rank is left to whoever knows when the rank was last evaluated, the
+        // segment of the trace before (see Vampire::estimate_segments())
+        static const uint64_t DEFERRED = UINT64_MAX;
+
+        uint64_t channel = 0ul, rank = 0ul;
+        uint64_t openBankCount = 0ul;               // The rank is in precharge standby when none of its banks is open
+        uint64_t lastStandbyEnergyEvalTime = 0ul;   // Time up to which the standby energy of the rank is accounted
+        uint64_t firstStandbyEvalTime = 0ul;        // First time the standby of the rank was evaluated after DEFERRED
+    };
+
+    /* State of every bank and rank of the device, sized from its geometry and flattened in (channel, rank, bank) order */
+    std::vector<Bank> banks;
+    std::vector<State> bankStates;                  // Only updated through setBankState(), which counts the open banks
+    std::vector<Rank> ranks;
+
+    uint64_t rankIndex(const MappedAdd &add) const {return add.channel * rankCount + add.rank;}
+    uint64_t bankIndex(const MappedAdd &add) const {return rankIndex(add) * bankCount + add.bank;}
+    Rank &rankOf(uint64_t bankNum) {return ranks[bankNum / bankCount];}
 
-    std::vector<Bank*> *banks;
-    std::vector<State> *bankStates;
+    /* Opens or closes the bank at bankIndex bankNum, keeping count of the open banks of its rank */
+    void setBankState(uint64_t bankNum, State state);
 
+private:
+    uint64_t rankCount;                             // # of ranks per channel
+    uint64_t bankCount;                             // # of banks per rank
 };
 
 static const long DEFAULT_STRUCT_COUNT[int(Level::MAX)] = {
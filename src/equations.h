@@ -28,26 +28,95 @@ protected:
     Config configs;
     TraceType traceType;
     VendorType vendorType;
-    DRAMdata ******memory;
     StructVar structVar;
 
     /* Lookup values for current variation based on structural variations */
-    std::vector<float> rdStructVarCurrent[int(VendorType::MAX)];                // For 8 banks
+    std::vector<float> rdStructVarCurrent[int(VendorType::MAX)];                // For STRUCT_VAR_BANKS banks
     std::function<float(int)> actStructVarCurrent[int(VendorType::MAX)]; // For current based on LR model
 
 public:
+    static const unsigned long STRUCT_VAR_BANKS = 8; // # of banks the structural variation of RD was measured on, only
+                                                     // for vendors A, B and C
+
     Equations(Statistics &statistics, DramSpec &dramSpec, Config &configs, VendorType &vendorType,
-                  TraceType &traceType, DRAMdata ******memory, StructVar structVar);
+                  TraceType &traceType, StructVar structVar);
     ~Equations() = default;
-    double_t calc_rd_wr_energy(CommandType request, MappedAdd add, unsigned int *data, uint32_t numSetBits,
-                               uint32_t numToggleBits, IO_data IO_buffer, EncodingType encodingType);
+    /*
+     * The energy equations are specialized for each vendor, so that the estimation loop of Vampire, which is itself
+     * specialized for the vendor, does not branch on it for every command
+     */
+    template <VendorType vendorT>
+    double_t calc_rd_wr_energy(CommandType request, const MappedAdd &add, unsigned int *data, uint32_t numSetBits,
+                               uint32_t numToggleBits, const IO_data &IO_buffer, EncodingType encodingType);
     void init_struct_var();
     void calculate_results(uint64_t &endTime, DramStruct &dramStruct);
-    double_t struct_var_power_adjustment(CommandType request, MappedAdd add);
-    float lookup_current_slope(CommandType, MappedAdd oldAdd, MappedAdd newAdd);
-    float lookup_current_intercept(CommandType, MappedAdd oldAdd, MappedAdd newAdd);
-    float lookup_toggle_current_slope   (CommandType, MappedAdd &newAdd, MappedAdd &oldAdd);
+    template <VendorType vendorT>
+    double_t struct_var_power_adjustment(CommandType request, const MappedAdd &add);
+    /* Interleaving of a RD/WR to add with the previous one, to prevAdd */
+    static CmdInterleaving interleaving(const MappedAdd &add, const MappedAdd &prevAdd);
+    /* Current coefficients of a RD/WR, from IO_CURRENTS or from the dramSpec file of Cust vendors */
+    template <VendorType vendorT>
+    const IoCurrent &io_current(CommandType request, CmdInterleaving interleaving) const;
 
 };
 
+/********************************************************************/
+/********************* DATA DEPENDENCY AND TOGGLE *******************/
+/********************************************************************/
+inline CmdInterleaving Equations::interleaving(const MappedAdd &add, const MappedAdd &prevAdd) {
+    if (add.bank != prevAdd.bank)
+        return add.col == prevAdd.col ? CmdInterleaving::BANK : CmdInterleaving::BANK_COL;
+    return add.col != prevAdd.col ? CmdInterleaving::COL : CmdInterleaving::NONE;
+}
+
+template <VendorType vendorT>
+const IoCurrent &Equations::io_current(CommandType request, CmdInterleaving interleaving) const {
+    if (vendorT == VendorType::Cust)
+        return dramSpec.ioCurrent[io_command(request)][int(interleaving)];
+    return IO_CURRENTS[int(vendorT)][io_command(request)][int(interleaving)];
+}
+
+template <VendorType vendorT>
+double_t Equations::calc_rd_wr_energy(CommandType request, const MappedAdd &add, unsigned int *data, uint32_t numSetBits,
+                                      uint32_t numToggleBits, const IO_data &IO_buffer, EncodingType encodingType) {
+    double_t result = 0.0;
+    const IoCurrent &ioCurrent = io_current<vendorT>(request, interleaving(add, IO_buffer.prevAdd));
+
+    dbgstream
+            << "current_intercept: " << ioCurrent.intercept
+            << ", current_slope: " << ioCurrent.slope
+            << ", current_toggle_slope :" << ioCurrent.toggleSlope;
+
+    if ((request == CommandType::WR) && (encodingType == EncodingType::CUSTOM_ADV))
+        numSetBits = 512 - numSetBits;
+
+    if (request == CommandType::RD || request == CommandType::WR) {
+        double_t current = ((numSetBits / 8.0f) * ioCurrent.slope
+                            + ioCurrent.intercept
+                            + (numToggleBits / 8.0f) * ioCurrent.toggleSlope);
+
+        result = current * dramSpec.getCmdLength()[int(request)];
+    } else
+        msg::error(FUNCTION_STR + ": Request is not an IO type");
+
+    assert(result != 0);
+    return result;
+}
+
+/* Lookup power numbers based on structural variation for given request.
+   Find energy and total request time */
+template <VendorType vendorT>
+double_t Equations::struct_var_power_adjustment(CommandType request, const MappedAdd &add) {
+    switch (int(request)) {
+        case (int(CommandType::RD)):
+            return rdStructVarCurrent[int(vendorT)][add.bank];
+
+        case (int(CommandType::ACT)):
+        case (int(CommandType::PRE)):
+            return actStructVarCurrent[int(vendorT)](add.row);
+        default:
+            return 1;
+    }
+}
+
 #endif //VAMPIRE_EQUATIONS_H
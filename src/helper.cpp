@@ -13,6 +13,133 @@ Released under the MIT License
 #include "helper.h"
 #include "config.h"
 
+#if (defined(__AVX512F__) && defined(__AVX512VPOPCNTDQ__)) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/* Seeds the state with the minimal standard generator and discards the first 310 draws, as srandom_r() does */
+Random::Random(unsigned int seed) {
+    int32_t word = seed == 0 ? 1 : (int32_t) seed;
+    state[0] = (uint32_t) word;
+    for (int i = 1; i < DEGREE; i++) {
+        // 16807 * word % 2147483647 without overflow
+        int32_t hi = word / 127773, lo = word % 127773;
+        word = 16807 * lo - 2836 * hi;
+        if (word < 0)
+            word += 2147483647;
+        state[i] = (uint32_t) word;
+    }
+    for (int i = 0; i < 10 * DEGREE; i++) {
+        next();
+    }
+}
+
+int Random::next() {
+    state[front] += state[rear];
+    int result = (int) (state[front] >> 1);
+    front = (front + 1) % DEGREE;
+    rear = (rear + 1) % DEGREE;
+    return result;
+}
+
+/* Calculates # of set bits in a line */
+unsigned int noSetBits(const unsigned int data[16])
+{
+#if defined(__AVX512F__) && defined(__AVX512VPOPCNTDQ__)
+  // The whole line is a single aligned 512-bit load
+  __m512i line = _mm512_load_si512((const void *) data);
+  return (unsigned int) _mm512_reduce_add_epi64(_mm512_popcnt_epi64(line));
+#else
+  uint64_t words[8];
+  unsigned int count = 0;
+
+  memcpy(words, data, sizeof(words));
+  for (int eightbytes = 0; eightbytes < 8; eightbytes++){
+    count += __builtin_popcountll(words[eightbytes]);
+  }
+  return count;
+#endif
+}
+
+/* Calculates # of bits that differ between two lines */
+unsigned int toggle(const unsigned int new_data[16], const unsigned int old_data[16])
+{
+#if defined(__AVX512F__) && defined(__AVX512VPOPCNTDQ__)
+  __m512i diff = _mm512_xor_si512(_mm512_load_si512((const void *) new_data), _mm512_load_si512((const void *) old_data));
+  return (unsigned int) _mm512_reduce_add_epi64(_mm512_popcnt_epi64(diff));
+#else
+  uint64_t newWords[8], oldWords[8];
+  unsigned int count = 0;
+
+  memcpy(newWords, new_data, sizeof(newWords));
+  memcpy(oldWords, old_data, sizeof(oldWords));
+  for (int eightbytes = 0; eightbytes < 8; eightbytes++){
+    count += __builtin_popcountll(newWords[eightbytes] ^ oldWords[eightbytes]);
+  }
+  return count;
+#endif
+}
+
+/* Decodes 128 hex digits into 16 words, the digits of each word are most significant first */
+bool decodeHexLine(const char *hex, unsigned int data[16])
+{
+#if defined(__AVX2__)
+  // Nibbles are computed for both the digit and the letter interpretation of every byte and the valid one is kept,
+  // pairs of nibbles are then merged into bytes (maddubs) and each word is byte swapped to get its big-endian value
+  const __m256i zeroMinusOne = _mm256_set1_epi8('0' - 1), ninePlusOne = _mm256_set1_epi8('9' + 1);
+  const __m256i aMinusOne = _mm256_set1_epi8('a' - 1), fPlusOne = _mm256_set1_epi8('f' + 1);
+  const __m256i lowerCase = _mm256_set1_epi8(0x20);
+  const __m256i merge = _mm256_set1_epi16(0x0110);
+  const __m256i swapWords = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                             3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+  __m256i invalid = _mm256_setzero_si256();
+  __m256i nibblePairs[4];
+
+  for (int chunk = 0; chunk < 4; chunk++) {
+    __m256i chars = _mm256_loadu_si256((const __m256i *) (hex + 32 * chunk));
+    __m256i lower = _mm256_or_si256(chars, lowerCase);
+    __m256i isDigit = _mm256_and_si256(_mm256_cmpgt_epi8(chars, zeroMinusOne), _mm256_cmpgt_epi8(ninePlusOne, chars));
+    __m256i isLetter = _mm256_and_si256(_mm256_cmpgt_epi8(lower, aMinusOne), _mm256_cmpgt_epi8(fPlusOne, lower));
+    invalid = _mm256_or_si256(invalid, _mm256_andnot_si256(_mm256_or_si256(isDigit, isLetter), _mm256_set1_epi8(-1)));
+
+    __m256i nibbles = _mm256_blendv_epi8(_mm256_sub_epi8(lower, _mm256_set1_epi8('a' - 10)),
+                                         _mm256_sub_epi8(chars, _mm256_set1_epi8('0')), isDigit);
+    nibblePairs[chunk] = _mm256_maddubs_epi16(nibbles, merge);
+  }
+  if (!_mm256_testz_si256(invalid, invalid))
+    return false;
+
+  for (int half = 0; half < 2; half++) {
+    // packus interleaves the 128-bit lanes of its operands, the permute puts the bytes back in order
+    __m256i bytes = _mm256_packus_epi16(nibblePairs[2 * half], nibblePairs[2 * half + 1]);
+    bytes = _mm256_permute4x64_epi64(bytes, 0xD8);
+    _mm256_storeu_si256((__m256i *) (data + 8 * half), _mm256_shuffle_epi8(bytes, swapWords));
+  }
+  return true;
+#else
+  static const struct NibbleTable {
+    int8_t values[256];
+    NibbleTable() {
+      memset(values, -1, sizeof(values));
+      for (int digit = 0; digit < 10; digit++) values['0' + digit] = (int8_t) digit;
+      for (int letter = 0; letter < 6; letter++) values['a' + letter] = values['A' + letter] = (int8_t) (10 + letter);
+    }
+  } table;
+  int8_t invalid = 0;
+
+  for (int word = 0; word < 16; word++) {
+    unsigned int value = 0;
+    for (int digit = 0; digit < 8; digit++) {
+      int8_t nibble = table.values[(uint8_t) hex[8 * word + digit]];
+      invalid |= nibble;
+      value = (value << 4) | (unsigned int) (nibble & 0xF);
+    }
+    data[word] = value;
+  }
+  return invalid >= 0;
+#endif
+}
+
 /* Calculates percentage of set bits in data */
 float percentSetBits(unsigned int data[16])
 {
@@ -73,6 +200,22 @@ namespace Helper {
         }
         return result;
     }
+
+    uint64_t parseSize(const std::string str) {
+        char *suffix = nullptr;
+        uint64_t size = strtoull(str.c_str(), &suffix, 10);
+
+        if (suffix == str.c_str())
+            return 0;
+
+        switch (toupper(*suffix)) {
+            case 'G': size <<= 10; // Fall through
+            case 'M': size <<= 10; // Fall through
+            case 'K': size <<= 10; suffix++; break;
+            default: break;
+        }
+        return (*suffix == '\0') ? size : 0;
+    }
 }
 
 /*******************/
@@ -140,5 +283,4 @@ void DRAMdata::init_values(){
     for(int fourbytes = 0; fourbytes < 16; fourbytes++){
         data[fourbytes] = 0;
     }
-    encoded = 0;
 }
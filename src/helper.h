@@ -28,6 +28,8 @@ namespace Helper {
     int verify_add(CommandType request, MappedAdd reqAdd, Config &configs);
     /* Results a vector of strings split at token */
     std::vector<std::string> splitStr(const std::string str, const char token);
+    /* Parses a size in bytes with an optional K, M or G suffix (powers of 1024), returns 0 if malformed */
+    uint64_t parseSize(const std::string str);
 
     /* Finds location of an element in a vector, returns -1 if not found */
     template <typename T>
@@ -59,22 +61,43 @@ namespace Helper {
 
 class IO_data{
 public:
-    unsigned int data[16];
+    alignas(64) unsigned int data[16];
     MappedAdd prevAdd;
     void init_values(void);
 };
 
 
-class DRAMdata{
+/* A line of data, aligned so that it occupies exactly one cache line. Whether it is stored in encoded form is kept by
+ * its owner (see MemoryImage) */
+class alignas(64) DRAMdata{
 public:
     unsigned int data[16];
-    unsigned int encoded; /* Whether the data stored is in encoded form*/
     void init_values(void);
 };
 
-unsigned int toggle(unsigned int[], unsigned int[]);
+/* Bit counting kernels over a 64-byte line, the lines must be 64-byte aligned */
+unsigned int toggle(const unsigned int[], const unsigned int[]);
 float percentSetBits(unsigned int[]);
-unsigned int noSetBits(unsigned int[]);
+unsigned int noSetBits(const unsigned int[]);
+
+/* Decodes the 128 hex digits of a line as written in ASCII traces (each 8 digits are one big-endian word of data),
+ * returns false if any of them is not a hex digit */
+bool decodeHexLine(const char *hex, unsigned int data[16]);
+
+/* Draws the sequence of rand() of glibc after srand(seed), as a value that each estimator keeps (and copies) on its own
+ * instead of the state shared by the whole process */
+class Random {
+private:
+    static const int DEGREE = 31;           // Of the additive feedback generator of glibc (TYPE_3)
+    static const int SEPARATION = 3;
+
+    uint32_t state[DEGREE];
+    int front = SEPARATION;                 // Position of the next word, the one DEGREE - SEPARATION after is added to it
+    int rear = 0;
+public:
+    explicit Random(unsigned int seed = 1);
+    int next();
+};
 
 class msg {
 private:
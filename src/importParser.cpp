@@ -0,0 +1,301 @@
+/*
+
+IMPORTPARSER.CPP
+
+VAMPIRE: Variation-Aware model of Memory Power Informed by Real Experiments
+https://github.com/CMU-SAFARI/VAMPIRE
+
+Copyright (c) SAFARI Research Group at Carnegie Mellon University and ETH Zürich
+Released under the MIT License
+
+*/
+
+#include <cctype>
+#include <cstring>
+
+#include "importParser.h"
+
+/************************/
+/* Class : ImportParser */
+/************************/
+ImportParser::ImportParser(const std::string &format) : format(format) {}
+
+void ImportParser::setTraceType(TraceType traceType) {
+    if (traceType == TraceType::WR || traceType == TraceType::RD_WR)
+        msg::error(format + " traces carry no data, use the MEAN or DIST model, see vampire --help for more details.");
+    Parser::setTraceType(traceType);
+}
+
+bool ImportParser::seek(uint64_t offset, const Command &previous) {
+    return false;
+}
+
+size_t ImportParser::split(const char *line, size_t length, Field fields[], size_t maxFields) {
+    size_t count = 0;
+    size_t pos = 0;
+
+    while (pos < length && count < maxFields) {
+        while (pos < length && (line[pos] == ',' || isspace((unsigned char) line[pos])))
+            pos++;
+        if (pos == length)
+            break;
+
+        fields[count].begin = line + pos;
+        while (pos < length && line[pos] != ',' && !isspace((unsigned char) line[pos]))
+            pos++;
+        fields[count].length = line + pos - fields[count].begin;
+        count++;
+    }
+    return count;
+}
+
+void ImportParser::malformed(const char *line, size_t length) const {
+    msg::error("Illegal " + format + " trace format, error at `" + std::string(line, length) + "'.");
+    exit(-1);
+}
+
+uint64_t ImportParser::to_uint(const Field &field, const char *line, size_t length) const {
+    const char *digit = field.begin;
+    const char *fieldEnd = field.begin + field.length;
+    unsigned int base = 10;
+    uint64_t value = 0;
+
+    if (field.length > 2 && digit[0] == '0' && (digit[1] == 'x' || digit[1] == 'X')) {
+        base = 16;
+        digit += 2;
+    }
+    if (fieldEnd - digit > (base == 16 ? 16 : 19))
+        malformed(line, length);
+
+    for (; digit < fieldEnd; digit++) {
+        unsigned int digitValue;
+        if (*digit >= '0' && *digit <= '9')
+            digitValue = (unsigned int) (*digit - '0');
+        else if (base == 16 && (*digit | 0x20) >= 'a' && (*digit | 0x20) <= 'f')
+            digitValue = (unsigned int) ((*digit | 0x20) - 'a' + 10);
+        else
+            malformed(line, length);
+        value = value * base + digitValue;
+    }
+    return value;
+}
+
+const ImportParser::CommandName &ImportParser::lookup(const CommandName names[], const Field &field,
+                                                      const char *line, size_t length) const {
+    for (const CommandName *name = names; name->name != nullptr; name++) {
+        if (strlen(name->name) == field.length && memcmp(name->name, field.begin, field.length) == 0)
+            return *name;
+    }
+    msg::error("Unknown " + format + " command `" + std::string(field.begin, field.length) + "' at `"
+               + std::string(line, length) + "'.");
+    exit(-1);
+}
+
+/* Banks are opened by ACT and closed by PRE, RDA and WRA, as in the estimation */
+void ImportParser::track(const Command &cmd) {
+    auto bank = openBanks.begin();
+    while (bank != openBanks.end() && (bank->channel != cmd.add.channel || bank->rank != cmd.add.rank
+                                       || bank->bank != cmd.add.bank))
+        bank++;
+
+    if (cmd.type == CommandType::ACT && bank == openBanks.end())
+        openBanks.push_back(cmd.add);
+    else if ((cmd.type == CommandType::PRE || cmd.type == CommandType::RDA || cmd.type == CommandType::WRA)
+             && bank != openBanks.end())
+        openBanks.erase(bank);
+}
+
+bool ImportParser::parse(bool &wasDataRead, Command &cmd) {
+    const char *line;
+    size_t length;
+    wasDataRead = false;
+
+    if (prechargePos < precharges.size()) {
+        cmd = precharges[prechargePos++];
+        return true;
+    }
+
+    while (next_line(line, length)) {
+        switch (int(decode_line(line, length, cmd))) {
+            case (int(ImportAction::COMMAND)): {
+                track(cmd);
+                if (!selection.matches(cmd.add.channel, cmd.add.rank, cmd.add.bank)) {
+                    skippedUntil = std::max(skippedUntil, cmd.issueTime);
+                    break;
+                }
+                memset(cmd.data, 0, sizeof(cmd.data));
+                return true;
+            }
+            case (int(ImportAction::PREA)): {
+                // PRE of every open bank of the rank, issued with the PREA
+                precharges.clear();
+                prechargePos = 0;
+                for (auto bank = openBanks.begin(); bank != openBanks.end();) {
+                    if (bank->channel != cmd.add.channel || bank->rank != cmd.add.rank) {
+                        bank++;
+                        continue;
+                    }
+                    if (selection.matches(bank->channel, bank->rank, bank->bank)) {
+                        Command pre = cmd;
+                        pre.type = CommandType::PRE;
+                        pre.add = *bank;
+                        memset(pre.data, 0, sizeof(pre.data));
+                        precharges.push_back(pre);
+                    } else {
+                        skippedUntil = std::max(skippedUntil, cmd.issueTime);
+                    }
+                    bank = openBanks.erase(bank);
+                }
+                if (precharges.empty())
+                    break;
+                cmd = precharges[prechargePos++];
+                return true;
+            }
+            case (int(ImportAction::SKIP)): {
+                skipped++;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    if (skipped > 0) {
+        msg::warning(std::to_string(skipped) + " refresh, power down and self refresh commands of the " + format
+                     + " trace were skipped, VAMPIRE does not model them.");
+        skipped = 0;
+    }
+    return false;
+}
+
+/***************************/
+/* Class : RamulatorParser */
+/***************************/
+RamulatorParser::RamulatorParser() : ImportParser("Ramulator") {}
+
+ImportAction RamulatorParser::decode_line(const char *line, size_t length, Command &cmd) const {
+    static const CommandName names[] = {
+            {"ACT",   ImportAction::COMMAND, CommandType::ACT},
+            {"PRE",   ImportAction::COMMAND, CommandType::PRE},
+            {"PREA",  ImportAction::PREA,    CommandType::PREA},
+            {"PRA",   ImportAction::PREA,    CommandType::PREA},
+            {"RD",    ImportAction::COMMAND, CommandType::RD},
+            {"WR",    ImportAction::COMMAND, CommandType::WR},
+            {"RDA",   ImportAction::COMMAND, CommandType::RDA},
+            {"WRA",   ImportAction::COMMAND, CommandType::WRA},
+            {"REF",   ImportAction::SKIP,    CommandType::REF},
+            {"REFPB", ImportAction::SKIP,    CommandType::REFB},
+            {"REFSB", ImportAction::SKIP,    CommandType::REFB},
+            {"PDE",   ImportAction::SKIP,    CommandType::PDN_F_PRE},
+            {"PDX",   ImportAction::SKIP,    CommandType::PDN_F_PRE},
+            {"SRE",   ImportAction::SKIP,    CommandType::SREN},
+            {"SRX",   ImportAction::SKIP,    CommandType::SREX},
+            {nullptr, ImportAction::NONE,    CommandType::MAX}
+    };
+    Field fields[3];
+    size_t count = split(line, length, fields, 3);
+
+    if (count == 0 || *fields[0].begin == '#')
+        return ImportAction::NONE;
+    if (count < 2)
+        malformed(line, length);
+
+    const CommandName &name = lookup(names, fields[1], line, length);
+    if (name.action != ImportAction::COMMAND && name.action != ImportAction::PREA)
+        return name.action;
+    if (name.action == ImportAction::COMMAND && count < 3)
+        malformed(line, length);
+
+    cmd.issueTime = to_uint(fields[0], line, length);
+    cmd.type = name.type;
+    cmd.add = MappedAdd(0, 0, (count == 3) ? to_uint(fields[2], line, length) : 0, 0, 0);
+    return name.action;
+}
+
+/**************************/
+/* Class : DramSim3Parser */
+/**************************/
+DramSim3Parser::DramSim3Parser() : ImportParser("DRAMSim3") {}
+
+ImportAction DramSim3Parser::decode_line(const char *line, size_t length, Command &cmd) const {
+    static const CommandName names[] = {
+            {"activate",           ImportAction::COMMAND, CommandType::ACT},
+            {"precharge",          ImportAction::COMMAND, CommandType::PRE},
+            {"read",               ImportAction::COMMAND, CommandType::RD},
+            {"write",              ImportAction::COMMAND, CommandType::WR},
+            {"read_p",             ImportAction::COMMAND, CommandType::RDA},
+            {"write_p",            ImportAction::COMMAND, CommandType::WRA},
+            {"refresh",            ImportAction::SKIP,    CommandType::REF},
+            {"refresh_bank",       ImportAction::SKIP,    CommandType::REFB},
+            {"self_refresh_enter", ImportAction::SKIP,    CommandType::SREN},
+            {"self_refresh_exit",  ImportAction::SKIP,    CommandType::SREX},
+            {nullptr,              ImportAction::NONE,    CommandType::MAX}
+    };
+    Field fields[8];
+    size_t count = split(line, length, fields, 8);
+
+    if (count == 0 || *fields[0].begin == '#')
+        return ImportAction::NONE;
+    if (count < 2)
+        malformed(line, length);
+
+    const CommandName &name = lookup(names, fields[1], line, length);
+    if (name.action != ImportAction::COMMAND)
+        return name.action;
+    if (count < 8)
+        malformed(line, length);
+
+    cmd.issueTime = to_uint(fields[0], line, length);
+    cmd.type = name.type;
+    cmd.add = MappedAdd(to_uint(fields[2], line, length), to_uint(fields[3], line, length),
+                        to_uint(fields[4], line, length) * DRAMSIM3_BANKS_PER_GROUP + to_uint(fields[5], line, length),
+                        to_uint(fields[6], line, length), to_uint(fields[7], line, length));
+    return name.action;
+}
+
+/***************************/
+/* Class : DramPowerParser */
+/***************************/
+DramPowerParser::DramPowerParser() : ImportParser("DRAMPower") {}
+
+ImportAction DramPowerParser::decode_line(const char *line, size_t length, Command &cmd) const {
+    static const CommandName names[] = {
+            {"ACT",       ImportAction::COMMAND, CommandType::ACT},
+            {"PRE",       ImportAction::COMMAND, CommandType::PRE},
+            {"PREA",      ImportAction::PREA,    CommandType::PREA},
+            {"RD",        ImportAction::COMMAND, CommandType::RD},
+            {"WR",        ImportAction::COMMAND, CommandType::WR},
+            {"RDA",       ImportAction::COMMAND, CommandType::RDA},
+            {"WRA",       ImportAction::COMMAND, CommandType::WRA},
+            {"REF",       ImportAction::SKIP,    CommandType::REF},
+            {"REFB",      ImportAction::SKIP,    CommandType::REFB},
+            {"PDN_F_ACT", ImportAction::SKIP,    CommandType::PDN_F_ACT},
+            {"PDN_S_ACT", ImportAction::SKIP,    CommandType::PDN_F_ACT},
+            {"PDN_F_PRE", ImportAction::SKIP,    CommandType::PDN_F_PRE},
+            {"PDN_S_PRE", ImportAction::SKIP,    CommandType::PDN_S_PRE},
+            {"PUP_ACT",   ImportAction::SKIP,    CommandType::PDN_F_ACT},
+            {"PUP_PRE",   ImportAction::SKIP,    CommandType::PDN_F_PRE},
+            {"SREN",      ImportAction::SKIP,    CommandType::SREN},
+            {"SREX",      ImportAction::SKIP,    CommandType::SREX},
+            {"NOP",       ImportAction::NONE,    CommandType::MAX},
+            {nullptr,     ImportAction::NONE,    CommandType::MAX}
+    };
+    Field fields[3];
+    size_t count = split(line, length, fields, 3);
+
+    if (count == 0 || *fields[0].begin == '#')
+        return ImportAction::NONE;
+    if (count < 2)
+        malformed(line, length);
+
+    const CommandName &name = lookup(names, fields[1], line, length);
+    if (name.action != ImportAction::COMMAND && name.action != ImportAction::PREA)
+        return name.action;
+    if (count < 3)
+        malformed(line, length);
+
+    cmd.issueTime = to_uint(fields[0], line, length);
+    cmd.type = name.type;
+    cmd.add = MappedAdd(0, 0, to_uint(fields[2], line, length), 0, 0);
+    return name.action;
+}
@@ -0,0 +1,107 @@
+/*
+
+IMPORTPARSER.H
+
+VAMPIRE: Variation-Aware model of Memory Power Informed by Real Experiments
+https://github.com/CMU-SAFARI/VAMPIRE
+
+Copyright (c) SAFARI Research Group at Carnegie Mellon University and ETH Zürich
+Released under the MIT License
+
+*/
+
+#ifndef VAMPIRE_IMPORTPARSER_H
+#define VAMPIRE_IMPORTPARSER_H
+
+#include <string>
+#include <vector>
+
+#include "parser.h"
+
+/* What VAMPIRE does with a command of another simulator */
+enum class ImportAction {COMMAND, PREA, SKIP, NONE, MAX};      // Estimate it, close all banks of its rank, skip it,
+                                                               // not a command (empty line or comment)
+
+/*
+ * Reads the command traces of other DRAM simulators directly, one command per line, tokenized in place as ASCII
+ * traces are. Only the commands VAMPIRE models are handed out: a PREA becomes a PRE for every bank of its rank that
+ * is open, refresh, power down and self refresh commands are skipped and counted. These traces carry no data, the
+ * data of every command is zero.
+ */
+class ImportParser : public AsciiParser {
+private:
+    std::string format;
+    std::vector<MappedAdd> openBanks;
+    std::vector<Command> precharges;        // PREs of the last PREA, handed out in order
+    size_t prechargePos = 0;
+    uint64_t skipped = 0;                   // # of commands skipped, reported at the end of the trace
+
+    void track(const Command &cmd);
+protected:
+    struct Field {
+        const char *begin;
+        size_t length;
+    };
+    struct CommandName {
+        const char *name;
+        ImportAction action;
+        CommandType type;
+    };
+
+    /* Splits a line into fields separated by commas and whitespace, returns the # of fields (at most maxFields) */
+    static size_t split(const char *line, size_t length, Field fields[], size_t maxFields);
+    /* Parses a decimal or 0x prefixed hexadecimal field, exits on anything else */
+    uint64_t to_uint(const Field &field, const char *line, size_t length) const;
+    /* Looks the name of a command up in a table ending with a nullptr name, exits on unknown commands */
+    const CommandName &lookup(const CommandName names[], const Field &field, const char *line, size_t length) const;
+    [[noreturn]] void malformed(const char *line, size_t length) const;
+
+    /* Decodes a line without its newline into the issue time, type and address of cmd */
+    virtual ImportAction decode_line(const char *line, size_t length, Command &cmd) const = 0;
+public:
+    explicit ImportParser(const std::string &format);
+
+    void setTraceType(TraceType traceType) override;
+    bool parse(bool &wasDataRead, Command &cmd) override;
+    /* The open banks and pending PREs of a PREA are not part of the checkpoints of an index */
+    bool seek(uint64_t offset, const Command &previous) override;
+};
+
+/*
+ * Command traces of Ramulator (record_cmd_trace), one file per rank:
+ *   <cycle>,<command>[,<bank>]
+ * Ramulator already folds the bank group into the bank of DDR4 and GDDR5 commands.
+ */
+class RamulatorParser : public ImportParser {
+protected:
+    ImportAction decode_line(const char *line, size_t length, Command &cmd) const override;
+public:
+    RamulatorParser();
+};
+
+/*
+ * Command traces of DRAMSim3 (CMD_TRACE), addresses are decimal or hexadecimal:
+ *   <cycle> <command> <channel> <rank> <bank group> <bank> <row> <column>
+ * The bank group is folded into the bank with DRAMSIM3_BANKS_PER_GROUP banks per group.
+ */
+class DramSim3Parser : public ImportParser {
+private:
+    static const unsigned int DRAMSIM3_BANKS_PER_GROUP = 4;
+protected:
+    ImportAction decode_line(const char *line, size_t length, Command &cmd) const override;
+public:
+    DramSim3Parser();
+};
+
+/*
+ * Command traces of DRAMPower (-c), which VAMPIRE's ASCII format is derived from:
+ *   <cycle>,<command>,<bank>
+ */
+class DramPowerParser : public ImportParser {
+protected:
+    ImportAction decode_line(const char *line, size_t length, Command &cmd) const override;
+public:
+    DramPowerParser();
+};
+
+#endif //VAMPIRE_IMPORTPARSER_H
@@ -25,17 +25,47 @@ T get_param(const std::string *refEnumArr, const std::string paramStr, std::stri
 void print_help() {
     const char *helpText =
             "usage:\n"
-            "   vampire -f <trace_file_name> -c <config_file> -d {RD_WR|WR|MEAN|DIST} -p {BINARY|ASCII} [-v {A|B|C|Cust}] [-dramSpec <dramSpec_file>] [-s]\n"
+            "   vampire -f <trace_file_name> -c <config_file> -d {RD_WR|WR|MEAN|DIST} -p {BINARY|ASCII|RAMULATOR|DRAMSIM3|DRAMPOWER} [-v {A|B|C|Cust}] [-dramSpec <dramSpec_file>] [-s]\n"
             "\n"
             "options: \n"
-            "   -f <trace_file_name>                Trace file to parse\n"
+            "   -f <trace_file_name>                Trace file to parse, - reads the trace from the standard input\n"
             "   -c <config_file>                    Config file\n"
             "   -d {MEAN|DIST|RD_WR|WR}             Data dependency model\n"
-            "   -p {BINARY|ASCII}                   Specifies parser to be used (Note: Current traceGen only generates binary traces)\n"
+            "   -p {BINARY|ASCII|RAMULATOR|DRAMSIM3|DRAMPOWER}\n"
+            "                                       Specifies parser to be used (Note: Current traceGen only generates binary traces). RAMULATOR,\n"
+            "                                       DRAMSIM3 and DRAMPOWER read the command traces of these simulators, with the MEAN or DIST model\n"
             "   -v {A|B|C|Cust}                     Specifies vendor for calculations, default: A. Cust vendor requires an additional dramspec file, specified using -dramSpec option.\n"
             "   -dramSpec <dramspec_file>           Specifies DRAM specifications for calculations, required for Cust vendor type\n"
             // "   -e {BDI|CUSTOM|CUSTOM_MAX|NONE}     Specifies encoding, default: NONE\n"
-            "   -s                                  Enables structural variations\n"
+            "   -s                                  Enables structural variations, of vendors A, B and C with up to 8 banks\n"
+            "   -memImage {SPARSE|FLAT|DEDUP|COMPRESSED}\n"
+            "                                       Backing store for the memory contents of the WR model, default: SPARSE\n"
+            "   -memLimit <bytes>[K|M|G]            Bounds the RAM holding rows of the SPARSE memory image, cold rows are spilled to $TMPDIR\n"
+            "   -memImageIn <snapshot_file>         Initial memory contents of the WR model, mapped from a snapshot written by -memImageOut\n"
+            "   -memImageOut <snapshot_file>        Writes the memory contents of the WR model to a snapshot at the end of the trace\n"
+            "   -parseDepth <batches>               Decodes the trace on a separate thread up to the given # of batches ahead, default: 0 (same thread)\n"
+            "   -parseBatch <commands>              # of commands decoded per batch, default: 256\n"
+            "   -traceOut <trace_file>              Writes the commands of the trace as a version 2 binary trace (see src/traceFormat.h)\n"
+            "   -parseThreads <threads>             Parses chunks of an ASCII trace on the given # of threads, default: 0 (sequential)\n"
+            "   -from <cycle>                       Only estimates the commands issued from the given cycle on, default: 0\n"
+            "   -to <cycle>                         Only estimates the commands issued up to the given cycle (inclusive), default: end of the trace\n"
+            "   -select <key>=<range>[,...]         Only estimates the commands in the given ranges of chan, rank and bank (<n> or <first>-<last>)\n"
+            "                                       and time (<start>:<end>), e.g. chan=0,bank=0-3,time=1000:5000\n"
+            "   -parallel {chan|rank}               Estimates each channel (or rank) on its own thread, as -select would estimate it alone, and\n"
+            "                                       adds up their statistics. Not supported with -traceOut and memory image snapshots\n"
+            "   -segments <n>                       Estimates the given # of time segments of the trace on their own threads, starting at the\n"
+            "                                       checkpoints of its index (see -buildIndex). Adds up to the estimate of the whole trace with the\n"
+            "                                       MEAN and RD_WR models, the WR model is estimated in one piece\n"
+            "   -sweep <config>[,...]               Estimates each of the given configurations <vendor>[:<dramSpec_file>][:s] in one pass over the\n"
+            "                                       trace instead of -v, -dramSpec and -s, e.g. A,B,C,A:s,Cust:dramSpec/example.cfg. Their stats are\n"
+            "                                       printed in order and written to <csv_filename> with the position of the configuration before\n"
+            "                                       its extension. Each configuration is estimated as a run of its own would, DIST included\n"
+            "   -buildIndex                         Writes a seekable index next to the trace (and the -traceOut trace), used by -from\n"
+            "   -indexInterval <commands>           # of commands between the checkpoints of the index, default: 65536\n"
+            "   -follow                             Waits for more commands at the end of the trace until its end-of-input marker\n"
+            "   -followTimeout <ms>                 Ends a followed trace after the given time without new commands, default: 0 (never)\n"
+            "   -directIO                           Reads the trace in large blocks around the page cache (O_DIRECT, io_uring), for traces larger than\n"
+            "                                       the page cache. Traces read this way cannot be seeked with an index\n"
             "   -csv <csv_filename>                 Specifies filename for VAMPIRE to write stats as csv to. If the file exists, it is overwritten else a new file is\n"
             "                                       created.\n";
 
@@ -98,6 +128,130 @@ void parse_args(int argc, char *argv[], Vampire &dram) {
             dram.parserType = get_param<ParserType>(parserTypeString, argv[i + 1], "ParserType");
         }
 
+        if (strcmp(argv[i], "-memImage") == 0) {
+            msg::error(argc <= i+1, "Option '-memImage': Memory image type not specified.");
+            msg::info("Using memory image: " + std::string(argv[i+1]));
+            dram.memImageType = get_param<MemImageType>(memImageTypeString, argv[i + 1], "MemImageType");
+        }
+
+        if (strcmp(argv[i], "-memLimit") == 0) {
+            msg::error(argc <= i+1, "Option '-memLimit': Memory limit not specified.");
+            msg::info("Memory image limit: " + std::string(argv[i+1]));
+            dram.memLimit = Helper::parseSize(argv[i+1]);
+            msg::error(dram.memLimit == 0, "Option '-memLimit': '" + std::string(argv[i+1]) + "' is not a valid size.");
+        }
+
+        if (strcmp(argv[i], "-parseDepth") == 0) {
+            msg::error(argc <= i+1, "Option '-parseDepth': # of batches not specified.");
+            msg::info("Parsing ahead by " + std::string(argv[i+1]) + " batches");
+            dram.parseDepth = std::stoul(argv[i+1]);
+        }
+
+        if (strcmp(argv[i], "-parseBatch") == 0) {
+            msg::error(argc <= i+1, "Option '-parseBatch': Batch size not specified.");
+            msg::info("Parse batch size: " + std::string(argv[i+1]));
+            dram.parseBatchSize = std::stoul(argv[i+1]);
+            msg::error(dram.parseBatchSize == 0, "Option '-parseBatch': Batch size must be positive.");
+        }
+
+        if (strcmp(argv[i], "-parseThreads") == 0) {
+            msg::error(argc <= i+1, "Option '-parseThreads': # of threads not specified.");
+            msg::info("Parsing on " + std::string(argv[i+1]) + " threads");
+            dram.parseThreads = std::stoul(argv[i+1]);
+        }
+
+        if (strcmp(argv[i], "-from") == 0) {
+            msg::error(argc <= i+1, "Option '-from': Start of the window not specified.");
+            msg::info("Estimating from cycle " + std::string(argv[i+1]));
+            dram.windowStart = std::stoull(argv[i+1]);
+        }
+
+        if (strcmp(argv[i], "-to") == 0) {
+            msg::error(argc <= i+1, "Option '-to': End of the window not specified.");
+            msg::info("Estimating up to cycle " + std::string(argv[i+1]));
+            dram.windowEnd = std::stoull(argv[i+1]);
+        }
+
+        if (strcmp(argv[i], "-select") == 0) {
+            msg::error(argc <= i+1, "Option '-select': Selection not specified.");
+            msg::info("Only estimating the commands of " + std::string(argv[i+1]));
+            dram.selection = Selection::parse(argv[i+1]);
+        }
+
+        if (strcmp(argv[i], "-parallel") == 0) {
+            msg::error(argc <= i+1, "Option '-parallel': Level not specified.");
+            std::string level(argv[i+1]);
+            if (level == "chan" || level == "channel")
+                dram.parallelLevel = Level::CHANNEL;
+            else if (level == "rank")
+                dram.parallelLevel = Level::RANK;
+            else
+                msg::error("Option '-parallel': unknown level `" + level + "', expected chan or rank.");
+            msg::info("Estimating each " + level + " on its own thread");
+        }
+
+        if (strcmp(argv[i], "-sweep") == 0) {
+            msg::error(argc <= i+1, "Option '-sweep': Configurations not specified.");
+            std::stringstream configs(argv[i+1]);
+            std::string config;
+            while (std::getline(configs, config, ','))
+                dram.sweep.push_back(SweepConfig::parse(config));
+            msg::info("Sweeping " + std::to_string(dram.sweep.size()) + " configurations");
+        }
+
+        if (strcmp(argv[i], "-segments") == 0) {
+            msg::error(argc <= i+1, "Option '-segments': # of segments not specified.");
+            msg::info("Splitting the trace into " + std::string(argv[i+1]) + " time segments");
+            dram.segments = std::stoul(argv[i+1]);
+            msg::error(dram.segments == 0, "Option '-segments': # of segments must be positive.");
+        }
+
+        if (strcmp(argv[i], "-buildIndex") == 0) {
+            msg::info("Building trace index");
+            dram.buildIndex = true;
+        }
+
+        if (strcmp(argv[i], "-indexInterval") == 0) {
+            msg::error(argc <= i+1, "Option '-indexInterval': # of commands not specified.");
+            msg::info("Trace index interval: " + std::string(argv[i+1]));
+            dram.indexInterval = std::stoull(argv[i+1]);
+            msg::error(dram.indexInterval == 0, "Option '-indexInterval': Interval must be positive.");
+        }
+
+        if (strcmp(argv[i], "-follow") == 0) {
+            msg::info("Following the trace until its end-of-input marker");
+            dram.follow = true;
+        }
+
+        if (strcmp(argv[i], "-followTimeout") == 0) {
+            msg::error(argc <= i+1, "Option '-followTimeout': Timeout not specified.");
+            msg::info("Follow timeout: " + std::string(argv[i+1]) + " ms");
+            dram.followTimeout = std::stoul(argv[i+1]);
+        }
+
+        if (strcmp(argv[i], "-directIO") == 0) {
+            msg::info("Reading the trace around the page cache");
+            dram.directIO = true;
+        }
+
+        if (strcmp(argv[i], "-memImageIn") == 0) {
+            msg::error(argc <= i+1, "Option '-memImageIn': Memory image snapshot not specified.");
+            msg::info("Initial memory image: " + std::string(argv[i+1]));
+            dram.memImageInFilename = new std::string(argv[i+1]);
+        }
+
+        if (strcmp(argv[i], "-memImageOut") == 0) {
+            msg::error(argc <= i+1, "Option '-memImageOut': Memory image snapshot not specified.");
+            msg::info("Final memory image: " + std::string(argv[i+1]));
+            dram.memImageOutFilename = new std::string(argv[i+1]);
+        }
+
+        if (strcmp(argv[i], "-traceOut") == 0) {
+            msg::error(argc <= i+1, "Option '-traceOut': Output trace not specified.");
+            msg::info("Writing version 2 binary trace: " + std::string(argv[i+1]));
+            dram.traceOutFilename = new std::string(argv[i+1]);
+        }
+
         if (strcmp(argv[i], "-dramSpec") == 0) {
             msg::error(argc <= i+1, "Option '-dramSpec': DramSpec file not specified.");
             msg::info("dramSpec file: " + std::string(argv[i+1]));
@@ -120,6 +274,7 @@ int main(int argc, char * argv[]){
     dram.encodingType = EncodingType::NONE;
     dram.structVar = StructVar::NO;
     dram.traceType = TraceType::WR;
+    dram.memImageType = MemImageType::SPARSE;
 
     parse_args(argc, argv, dram);
     dram.set_values();
@@ -12,13 +12,11 @@ Released under the MIT License
 
 #include "vampire.h"
 #include "helper.h"
+#include "mapping.h"
 
 
-/* Check if chosen encoding is possible on given data */
-int Vampire::check_for_encoding(unsigned int data[16]){
-
-    if (encodingType == EncodingType::BDI){
-
+namespace BDI {
+    int is_compressible(const unsigned int data[16]) {
         unsigned int base = data[0];
         unsigned int delta;
         unsigned int delta_extend;
@@ -37,6 +35,67 @@ int Vampire::check_for_encoding(unsigned int data[16]){
         return encoding;
     }
 
+    void compress(unsigned int data[16]) {
+        /*
+
+     The base is set to the first 4-byte value (V0).
+     The remaining values (V1..V15) are used to calcuated difference values from the base.
+     Resulting difference values (delta1...delta15) are then checked to see whether
+     their first 3 bytes are all zeros or ones (1 byte sign extension check).
+     If so the cache line can be compressed.
+
+     Compressed line will have the following format:
+
+     1. The first 4 bytes will be the base.
+     2. All other 4 byte values will be 0x80_00_00_delta or 0x00_00_00_delta.
+
+     0x80_00_00_delta implies value - base = 0xFF_FF_FF_delta
+     0x00_00_00_delta implies value - base = 0x00_00_00_delta
+
+     Here the 31st bit is used to indicate whether the delta value had leading zeros or ones
+    */
+
+        unsigned int base = data[0];
+        unsigned int delta;
+        unsigned int delta_extend;
+
+        /* The 0th element is the base */
+        for (int fourbytes = 1; fourbytes < 16; fourbytes++){
+            delta = data[fourbytes] - base;
+
+            delta_extend = (delta >> 8) & 0xFFFFFF;
+            delta        = delta & 0xFF;
+
+            if (delta_extend == 0xFFFFFF){
+                data[fourbytes] = delta | 0x80000000;
+            }
+            else if (delta_extend == 0x0){
+                data[fourbytes] = delta;
+            }
+        }
+    }
+
+    void decompress(unsigned int data[16]) {
+        unsigned int base = data[0];
+
+        for (int fourbytes = 1; fourbytes < 16; fourbytes++){
+            unsigned int delta = data[fourbytes] & 0xFF;
+
+            if (data[fourbytes] & 0x80000000)
+                delta |= 0xFFFFFF00;
+
+            data[fourbytes] = base + delta;
+        }
+    }
+}
+
+/* Check if chosen encoding is possible on given data */
+int Vampire::check_for_encoding(unsigned int data[16]){
+
+    if (encodingType == EncodingType::BDI){
+        return BDI::is_compressible(data);
+    }
+
     else if (encodingType == EncodingType::CUSTOM) {
         return 1;
     }
@@ -84,48 +143,8 @@ unsigned int * Vampire::apply_encoding(unsigned int data[16]){
  
   
     if (encodingType == EncodingType::BDI){
-
-        /*
-
-     The base is set to the first 4-byte value (V0).
-     The remaining values (V1..V15) are used to calcuated difference values from the base.                                                                                                                
-     Resulting difference values (delta1...delta15) are then checked to see whether                                                                                                                       
-     their first 3 bytes are all zeros or ones (1 byte sign extension check).                                                                                                                            
-     If so the cache line can be compressed.                                                                                                                                                             
-
-     Compressed line will have the following format:                                                                                                                                                       
-
-     1. The first 4 bytes will be the base. 
-     2. All other 4 byte values will be 0x80_00_00_delta or 0x00_00_00_delta.                                                                                                                              
-
-     0x80_00_00_delta implies value - base = 0xFF_FF_FF_delta 
-     0x00_00_00_delta implies value - base = 0x00_00_00_delta                    
-  
-     Here the 31st bit is used to indicate whether the delta value had leading zeros or ones
-    */
-               
-    
-        unsigned int base = data[0];
-        unsigned int delta;
-        unsigned int delta_extend;
-
-        /* The 0th element is the base */
-        for (int fourbytes = 1; fourbytes < 16; fourbytes++){
-            delta = data[fourbytes] - base;
-      
-            delta_extend = (delta >> 8) & 0xFFFFFF;
-            delta        = delta & 0xFF;
-
-            if (delta_extend == 0xFFFFFF){
-                data[fourbytes] = delta | 0x80000000;
-            }
-            else if (delta_extend == 0x0){
-                data[fourbytes] = delta;
-            }
-        }
-
+        BDI::compress(data);
         return &(data[0]);
-    
     }
 
 
@@ -0,0 +1,28 @@
+/*
+
+MAPPING.H
+
+VAMPIRE: Variation-Aware model of Memory Power Informed by Real Experiments
+https://github.com/CMU-SAFARI/VAMPIRE
+
+Copyright (c) SAFARI Research Group at Carnegie Mellon University and ETH Zürich
+Released under the MIT License
+
+*/
+
+#ifndef VAMPIRE_MAPPING_H
+#define VAMPIRE_MAPPING_H
+
+/* Base-Delta-Immediate encoding of a 64-byte line with a 4-byte base and 1-byte deltas */
+namespace BDI {
+    /* Returns 1 if every word of data is within a sign extended byte of data[0] */
+    int is_compressible(const unsigned int data[16]);
+
+    /* Replaces data[1..15] with their deltas from data[0], bit 31 of a delta is set if it is negative */
+    void compress(unsigned int data[16]);
+
+    /* Inverse of compress() */
+    void decompress(unsigned int data[16]);
+}
+
+#endif //VAMPIRE_MAPPING_H
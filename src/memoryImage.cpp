@@ -0,0 +1,758 @@
+/*
+
+MEMORYIMAGE.CPP
+
+VAMPIRE: Variation-Aware model of Memory Power Informed by Real Experiments
+https://github.com/CMU-SAFARI/VAMPIRE
+
+Copyright (c) SAFARI Research Group at Carnegie Mellon University and ETH Zürich
+Released under the MIT License
+
+*/
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "memoryImage.h"
+#include "mapping.h"
+
+/* Returned for every line that was never written, static storage keeps it zero initialized */
+static const DRAMdata ZERO_LINE = {};
+
+/***********************/
+/* Class : MemoryImage */
+/***********************/
+MemoryImage::MemoryImage(const Config &configs) {
+    structCount[int(Level::CHANNEL)] = configs.getNumChannels();
+    structCount[int(Level::RANK)]    = configs.getNumRanks();
+    structCount[int(Level::BANK)]    = configs.getNumBanks();
+    structCount[int(Level::ROW)]     = configs.getNumRows();
+    structCount[int(Level::COLUMN)]  = configs.getNumCols();
+
+    bitmapWords = (structCount[int(Level::COLUMN)] + 63) / 64;
+    rowSize = structCount[int(Level::COLUMN)] * sizeof(DRAMdata) + bitmapWords * sizeof(uint64_t);
+    rowSize = (rowSize + alignof(DRAMdata) - 1) / alignof(DRAMdata) * alignof(DRAMdata);
+}
+
+MemoryImage::~MemoryImage() {
+    if (snapshot != nullptr)
+        munmap((void *) snapshot, image_size());
+}
+
+uint64_t MemoryImage::row_count() const {
+    return structCount[int(Level::CHANNEL)] * structCount[int(Level::RANK)]
+           * structCount[int(Level::BANK)] * structCount[int(Level::ROW)];
+}
+
+DRAMdata *MemoryImage::alloc_row() const {
+    void *row = nullptr;
+    msg::error(posix_memalign(&row, alignof(DRAMdata), rowSize) != 0, "Unable to allocate a row for the memory image.");
+    memset(row, 0, rowSize);
+    return (DRAMdata *) row;
+}
+
+void *MemoryImage::map_snapshot(const std::string &path, bool writable) {
+    SnapshotHeader header = {};
+    struct stat fileStat = {};
+
+    int fd = open(path.c_str(), O_RDONLY);
+    msg::error(fd < 0, "Unable to open memory image snapshot '" + path + "'.");
+    msg::error(pread(fd, &header, sizeof(header), 0) != sizeof(header)
+               || memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0,
+               "'" + path + "' is not a memory image snapshot.");
+    msg::error(header.version != SNAPSHOT_VERSION || header.rowSize != rowSize,
+               "Memory image snapshot '" + path + "' was written by an incompatible version.");
+    msg::error(memcmp(header.structCount, structCount, sizeof(structCount)) != 0,
+               "Memory image snapshot '" + path + "' does not match the geometry of the configuration.");
+    msg::error(fstat(fd, &fileStat) != 0 || (size_t) fileStat.st_size < SNAPSHOT_DATA_OFFSET + image_size(),
+               "Memory image snapshot '" + path + "' is truncated.");
+
+    // Private mappings are never written back, a writable one only copies the pages that are modified
+    void *mapping = mmap(nullptr, image_size(), PROT_READ | (writable ? PROT_WRITE : 0),
+                         MAP_PRIVATE | MAP_NORESERVE, fd, SNAPSHOT_DATA_OFFSET);
+    msg::error(mapping == MAP_FAILED, "Unable to map memory image snapshot '" + path + "'.");
+
+    // Find the rows holding data by walking the allocated extents of the file, so that the holes are never read
+    snapshotRows.assign(row_count(), false);
+    off_t dataStart = lseek(fd, SNAPSHOT_DATA_OFFSET, SEEK_DATA);
+    if (dataStart < 0 && errno != ENXIO) {
+        snapshotRows.assign(row_count(), true); // File system cannot report holes
+    }
+    while (dataStart >= 0) {
+        off_t dataEnd = lseek(fd, dataStart, SEEK_HOLE);
+        uint64_t firstRow = (std::max<off_t>(dataStart, SNAPSHOT_DATA_OFFSET) - SNAPSHOT_DATA_OFFSET) / rowSize;
+        uint64_t lastRow = std::min<uint64_t>((dataEnd - SNAPSHOT_DATA_OFFSET + rowSize - 1) / rowSize, row_count());
+        for (uint64_t row = firstRow; row < lastRow; row++) {
+            snapshotRows[row] = true;
+        }
+        dataStart = lseek(fd, dataEnd, SEEK_DATA);
+    }
+    close(fd);
+
+    return mapping;
+}
+
+const DRAMdata &MemoryImage::snapshot_line(const MappedAdd &add, unsigned int &encoded) const {
+    const DRAMdata *row = snapshot_row(row_index(add));
+    if (row == nullptr) {
+        encoded = 0;
+        return ZERO_LINE;
+    }
+
+    encoded = is_encoded(encoded_bitmap(row), add.col);
+    return row[add.col];
+}
+
+void MemoryImage::load(const std::string &path) {
+    snapshot = (const DRAMdata *) map_snapshot(path, false);
+}
+
+/* Rows are written one at a time at their offset, rows that read as zero are skipped and stay holes in the file */
+void MemoryImage::dump(const std::string &path) {
+    DRAMdata *buffer = alloc_row();
+    SnapshotHeader header = {};
+
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.version = SNAPSHOT_VERSION;
+    header.rowSize = (uint32_t) rowSize;
+    memcpy(header.structCount, structCount, sizeof(structCount));
+
+    // Write to a temporary file first, the snapshot being dumped may be the one currently mapped
+    std::string tmpPath = path + ".tmp";
+    int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    msg::error(fd < 0, "Unable to create memory image snapshot '" + tmpPath + "'.");
+
+    bool failed = pwrite(fd, &header, sizeof(header), 0) != sizeof(header)
+                  || ftruncate(fd, SNAPSHOT_DATA_OFFSET + image_size()) != 0;
+
+    for (uint64_t row = 0; row < row_count() && !failed; row++) {
+        const DRAMdata *contents = row_contents(row, buffer);
+        if (contents == nullptr)
+            continue;
+
+        auto *bytes = (const unsigned char *) contents;
+        bool isZero = true;
+        for (size_t byte = 0; byte < rowSize && isZero; byte++) {
+            isZero = (bytes[byte] == 0);
+        }
+
+        if (!isZero)
+            failed = pwrite(fd, contents, rowSize, SNAPSHOT_DATA_OFFSET + row * rowSize) != (ssize_t) rowSize;
+    }
+
+    free(buffer);
+    failed = (close(fd) != 0) || failed;
+    msg::error(failed || rename(tmpPath.c_str(), path.c_str()) != 0,
+               "Unable to write memory image snapshot '" + path + "'.");
+    msg::info("Memory image written to '" + path + "'.");
+}
+
+/*****************************/
+/* Class : SparseMemoryImage */
+/*****************************/
+SparseMemoryImage::SparseMemoryImage(const Config &configs) : MemoryImage(configs) {
+    // calloc'd pages are mapped lazily by the OS, so untouched parts of the row table are free as well
+    rows = (DRAMdata **) calloc(row_count(), sizeof(DRAMdata *));
+    msg::error(rows == nullptr, "Unable to allocate the row table for the memory image.");
+}
+
+SparseMemoryImage::~SparseMemoryImage() {
+    for (uint64_t row = 0; row < row_count(); row++) {
+        free(rows[row]);
+    }
+    free(rows);
+}
+
+const DRAMdata *SparseMemoryImage::row_contents(uint64_t row, DRAMdata *buffer) {
+    return (rows[row] == nullptr) ? snapshot_row(row) : rows[row];
+}
+
+const DRAMdata &SparseMemoryImage::read(const MappedAdd &add, unsigned int &encoded) {
+    DRAMdata *row = rows[row_index(add)];
+    if (row == nullptr)
+        return snapshot_line(add, encoded);
+
+    encoded = is_encoded(encoded_bitmap(row), add.col);
+    return row[add.col];
+}
+
+void SparseMemoryImage::write(const MappedAdd &add, const unsigned int data[16], unsigned int encoded) {
+    uint64_t rowIndex = row_index(add);
+    DRAMdata *&row = rows[rowIndex];
+
+    if (row == nullptr) {
+        row = alloc_row();
+        materializedRows++;
+
+        if (snapshot_row(rowIndex) != nullptr)
+            memcpy(row, snapshot_row(rowIndex), rowSize);
+    }
+
+    DRAMdata &line = row[add.col];
+    for (int fourbytes = 0; fourbytes < 16; fourbytes++) {
+        line.data[fourbytes] = data[fourbytes];
+    }
+    set_encoded(encoded_bitmap(row), add.col, encoded);
+}
+
+void SparseMemoryImage::print_stats() const {
+    std::stringstream ss;
+    ss << "Memory image: " << materializedRows << " of " << row_count() << " rows materialized ("
+       << std::fixed << std::setprecision(2)
+       << (double)(materializedRows * rowSize) / (1024*1024)
+       << " MiB).";
+    msg::info(ss.str());
+}
+
+/*******************************/
+/* Class : SpillingMemoryImage */
+/*******************************/
+SpillingMemoryImage::SpillingMemoryImage(const Config &configs, uint64_t memLimit) : MemoryImage(configs) {
+    maxFrames = (uint32_t) std::min<uint64_t>(std::min<uint64_t>(memLimit / rowSize, row_count()), NONE - 1);
+    msg::error(maxFrames == 0, "Memory limit is smaller than a row (" + std::to_string(rowSize) + " bytes).");
+
+    rows = new RowEntry[row_count()];
+
+    // Frames are only backed once handed out, so small footprints stay small regardless of the limit
+    void *mapping = mmap(nullptr, (size_t) maxFrames * rowSize, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    msg::error(mapping == MAP_FAILED, "Unable to map the frames of the memory image.");
+    frames = (char *) mapping;
+
+    // The spill file is unlinked right away, it is reclaimed when VAMPIRE exits even if it is killed
+    const char *tmpDir = getenv("TMPDIR");
+    std::string spillPath = std::string((tmpDir != nullptr) ? tmpDir : "/tmp") + "/vampire-spill-XXXXXX";
+    spillFd = mkstemp(&spillPath[0]);
+    msg::error(spillFd < 0, "Unable to create the spill file of the memory image at '" + spillPath + "'.");
+    unlink(spillPath.c_str());
+}
+
+SpillingMemoryImage::~SpillingMemoryImage() {
+    close(spillFd);
+    munmap(frames, (size_t) maxFrames * rowSize);
+    delete[] rows;
+}
+
+/* Frees a frame with the CLOCK algorithm, writing its row to the spill file if it was modified */
+uint32_t SpillingMemoryImage::evict() {
+    while (frameTable[clockHand].referenced) {
+        frameTable[clockHand].referenced = false;
+        clockHand = (clockHand + 1) % maxFrames;
+    }
+
+    uint32_t frame = clockHand;
+    FrameEntry &victim = frameTable[frame];
+    RowEntry &victimRow = rows[victim.row];
+
+    if (victim.dirty) {
+        if (victimRow.spillSlot == NONE)
+            victimRow.spillSlot = spillSlots++;
+
+        ssize_t written = pwrite(spillFd, frame_data(frame), rowSize, (off_t) victimRow.spillSlot * rowSize);
+        msg::error(written != (ssize_t) rowSize, "Unable to write a row to the spill file of the memory image.");
+        writeBacks++;
+    }
+
+    victimRow.frame = NONE;
+    clockHand = (clockHand + 1) % maxFrames;
+    evictions++;
+    return frame;
+}
+
+/* Makes the row resident, reading it from the spill file or the snapshot */
+DRAMdata *SpillingMemoryImage::fault_in(uint64_t row) {
+    RowEntry &entry = rows[row];
+    uint32_t frame;
+
+    if (frameTable.size() < maxFrames) {
+        frame = (uint32_t) frameTable.size();
+        frameTable.emplace_back();
+    } else {
+        frame = evict();
+    }
+
+    DRAMdata *data = frame_data(frame);
+    if (entry.spillSlot != NONE) {
+        ssize_t read = pread(spillFd, data, rowSize, (off_t) entry.spillSlot * rowSize);
+        msg::error(read != (ssize_t) rowSize, "Unable to read a row from the spill file of the memory image.");
+        faults++;
+    } else if (snapshot_row(row) != nullptr) {
+        memcpy(data, snapshot_row(row), rowSize);
+    } else {
+        memset(data, 0, rowSize);
+    }
+
+    frameTable[frame] = {row, true, false};
+    entry.frame = frame;
+    return data;
+}
+
+const DRAMdata *SpillingMemoryImage::row_contents(uint64_t row, DRAMdata *buffer) {
+    const RowEntry &entry = rows[row];
+
+    if (entry.frame != NONE)
+        return frame_data(entry.frame);
+    if (entry.spillSlot == NONE)
+        return snapshot_row(row);
+
+    ssize_t read = pread(spillFd, buffer, rowSize, (off_t) entry.spillSlot * rowSize);
+    msg::error(read != (ssize_t) rowSize, "Unable to read a row from the spill file of the memory image.");
+    return buffer;
+}
+
+const DRAMdata &SpillingMemoryImage::read(const MappedAdd &add, unsigned int &encoded) {
+    uint64_t row = row_index(add);
+    const RowEntry &entry = rows[row];
+
+    // Rows that were never written do not take a frame
+    if (entry.frame == NONE && entry.spillSlot == NONE)
+        return snapshot_line(add, encoded);
+
+    DRAMdata *rowData;
+    if (entry.frame == NONE) {
+        rowData = fault_in(row);
+    } else {
+        frameTable[entry.frame].referenced = true;
+        rowData = frame_data(entry.frame);
+    }
+
+    encoded = is_encoded(encoded_bitmap(rowData), add.col);
+    return rowData[add.col];
+}
+
+void SpillingMemoryImage::write(const MappedAdd &add, const unsigned int data[16], unsigned int encoded) {
+    uint64_t row = row_index(add);
+    DRAMdata *rowData = (rows[row].frame == NONE) ? fault_in(row) : frame_data(rows[row].frame);
+
+    FrameEntry &frame = frameTable[rows[row].frame];
+    frame.referenced = true;
+    frame.dirty = true;
+
+    DRAMdata &line = rowData[add.col];
+    for (int fourbytes = 0; fourbytes < 16; fourbytes++) {
+        line.data[fourbytes] = data[fourbytes];
+    }
+    set_encoded(encoded_bitmap(rowData), add.col, encoded);
+}
+
+void SpillingMemoryImage::print_stats() const {
+    std::stringstream ss;
+    ss << "Memory image: " << frameTable.size() << " of " << maxFrames << " frames used ("
+       << std::fixed << std::setprecision(2) << (double)(frameTable.size() * rowSize) / (1024*1024) << " MiB), "
+       << spillSlots << " rows spilled (" << (double)((uint64_t) spillSlots * rowSize) / (1024*1024) << " MiB), "
+       << evictions << " evictions, " << writeBacks << " write-backs, " << faults << " faults.";
+    msg::info(ss.str());
+}
+
+/***************************/
+/* Class : FlatMemoryImage */
+/***************************/
+FlatMemoryImage::FlatMemoryImage(const Config &configs) : MemoryImage(configs) {
+    mappingSize = image_size();
+
+    // Anonymous mappings are zero filled, which is also the initial value of every line
+    void *anonymous = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    msg::error(anonymous == MAP_FAILED, "Unable to map " + std::to_string(mappingSize) + " bytes for the memory image.");
+
+#ifdef MADV_HUGEPAGE
+    madvise(anonymous, mappingSize, MADV_HUGEPAGE); // Only a hint, failure leaves regular pages in place
+#endif
+
+    mapping = (char *) anonymous;
+    writtenRows.assign(row_count(), false);
+}
+
+FlatMemoryImage::~FlatMemoryImage() {
+    munmap(mapping, mappingSize);
+}
+
+/* Replaces the anonymous mapping by a private mapping of the snapshot, pages are read in on first access and copied
+ * on first write so the snapshot file itself is never modified */
+void FlatMemoryImage::load(const std::string &path) {
+    void *snapshotMapping = map_snapshot(path, true);
+    munmap(mapping, mappingSize);
+    mapping = (char *) snapshotMapping;
+}
+
+const DRAMdata *FlatMemoryImage::row_contents(uint64_t row, DRAMdata *buffer) {
+    bool inSnapshot = !snapshotRows.empty() && snapshotRows[row];
+    return (writtenRows[row] || inSnapshot) ? row_at(row) : nullptr;
+}
+
+const DRAMdata &FlatMemoryImage::read(const MappedAdd &add, unsigned int &encoded) {
+    DRAMdata *row = row_at(row_index(add));
+    encoded = is_encoded(encoded_bitmap(row), add.col);
+    return row[add.col];
+}
+
+void FlatMemoryImage::write(const MappedAdd &add, const unsigned int data[16], unsigned int encoded) {
+    uint64_t rowIndex = row_index(add);
+    DRAMdata *row = row_at(rowIndex);
+    writtenRows[rowIndex] = true;
+
+    DRAMdata &line = row[add.col];
+    for (int fourbytes = 0; fourbytes < 16; fourbytes++) {
+        line.data[fourbytes] = data[fourbytes];
+    }
+    set_encoded(encoded_bitmap(row), add.col, encoded);
+}
+
+void FlatMemoryImage::print_stats() const {
+    std::stringstream ss;
+    ss << "Memory image: flat mapping of " << std::fixed << std::setprecision(2)
+       << (double)mappingSize / (1024*1024) << " MiB, backed on first write.";
+    msg::info(ss.str());
+}
+
+/****************************/
+/* Class : DedupMemoryImage */
+/****************************/
+size_t DedupMemoryImage::PayloadHash::operator()(uint32_t handle) const {
+    const auto &line = (*payloads)[handle];
+    uint64_t hash = 0;
+    for (int fourbytes = 0; fourbytes < 16; fourbytes += 2) {
+        hash ^= ((uint64_t)line.data[fourbytes+1] << 32) | line.data[fourbytes];
+        hash *= 0x9E3779B97F4A7C15ull;
+        hash ^= hash >> 29;
+    }
+    return (size_t) hash;
+}
+
+bool DedupMemoryImage::PayloadEqual::operator()(uint32_t lhs, uint32_t rhs) const {
+    const auto &lLine = (*payloads)[lhs];
+    const auto &rLine = (*payloads)[rhs];
+    return memcmp(lLine.data, rLine.data, sizeof(lLine.data)) == 0;
+}
+
+DedupMemoryImage::DedupMemoryImage(const Config &configs)
+        : MemoryImage(configs), index(0, PayloadHash{&payloads}, PayloadEqual{&payloads}) {
+    rows = (uint64_t **) calloc(row_count(), sizeof(uint64_t *));
+    msg::error(rows == nullptr, "Unable to allocate the row table for the memory image.");
+
+    payloads.push_back(ZERO_LINE); // Handle 0
+    refCount.push_back(0);
+}
+
+DedupMemoryImage::~DedupMemoryImage() {
+    for (uint64_t row = 0; row < row_count(); row++) {
+        free(rows[row]);
+    }
+    free(rows);
+}
+
+/* Returns a referenced handle for the given line, sharing the payload with an identical line if one is stored */
+uint32_t DedupMemoryImage::acquire(const unsigned int data[16]) {
+    unsigned int setWords = 0;
+    for (int fourbytes = 0; fourbytes < 16; fourbytes++) {
+        setWords |= data[fourbytes];
+    }
+    if (setWords == 0)
+        return 0;
+
+    // Stage the line in a free payload slot and use it as the lookup key
+    uint32_t handle;
+    if (freeHandles.empty()) {
+        msg::error(payloads.size() > UINT32_MAX, "Memory image: exhausted the 32-bit payload handles.");
+        handle = (uint32_t) payloads.size();
+        payloads.emplace_back();
+        refCount.push_back(0);
+    } else {
+        handle = freeHandles.back();
+        freeHandles.pop_back();
+    }
+
+    DRAMdata &line = payloads[handle];
+    for (int fourbytes = 0; fourbytes < 16; fourbytes++) {
+        line.data[fourbytes] = data[fourbytes];
+    }
+
+    auto inserted = index.insert(handle);
+    if (!inserted.second) {
+        // Identical payload is already stored, return the staging slot
+        freeHandles.push_back(handle);
+        handle = *inserted.first;
+    }
+
+    refCount[handle]++;
+    return handle;
+}
+
+void DedupMemoryImage::release(uint32_t handle) {
+    if (handle == 0)
+        return;
+
+    if (--refCount[handle] == 0) {
+        index.erase(handle);
+        freeHandles.push_back(handle);
+    }
+}
+
+const DRAMdata *DedupMemoryImage::row_contents(uint64_t row, DRAMdata *buffer) {
+    if (rows[row] == nullptr)
+        return snapshot_row(row);
+
+    for (uint64_t col = 0; col < structCount[int(Level::COLUMN)]; col++) {
+        buffer[col] = payloads[handles(rows[row])[col]];
+    }
+    memcpy(encoded_bitmap(buffer), rows[row], bitmapWords * sizeof(uint64_t));
+    return buffer;
+}
+
+const DRAMdata &DedupMemoryImage::read(const MappedAdd &add, unsigned int &encoded) {
+    uint64_t *row = rows[row_index(add)];
+    if (row == nullptr)
+        return snapshot_line(add, encoded);
+
+    encoded = is_encoded(row, add.col);
+    return payloads[handles(row)[add.col]];
+}
+
+void DedupMemoryImage::write(const MappedAdd &add, const unsigned int data[16], unsigned int encoded) {
+    uint64_t rowIndex = row_index(add);
+    uint64_t *&row = rows[rowIndex];
+
+    if (row == nullptr) {
+        row = (uint64_t *) calloc(1, bitmapWords * sizeof(uint64_t) + structCount[int(Level::COLUMN)] * sizeof(uint32_t));
+        msg::error(row == nullptr, "Unable to allocate a row for the memory image.");
+
+        // Take over the lines of the row from the snapshot, the row no longer reads through to it
+        const DRAMdata *snapshotRow = snapshot_row(rowIndex);
+        if (snapshotRow != nullptr) {
+            for (uint64_t col = 0; col < structCount[int(Level::COLUMN)]; col++) {
+                handles(row)[col] = acquire(snapshotRow[col].data);
+                liveLines += (handles(row)[col] != 0);
+            }
+            memcpy(row, encoded_bitmap(snapshotRow), bitmapWords * sizeof(uint64_t));
+        }
+    }
+
+    uint32_t &slot = handles(row)[add.col];
+    uint32_t handle = acquire(data); // Acquire first so that rewriting a line never drops its payload
+    release(slot);
+
+    liveLines += (handle != 0);
+    liveLines -= (slot != 0);
+    slot = handle;
+    set_encoded(row, add.col, encoded);
+}
+
+void DedupMemoryImage::print_stats() const {
+    uint64_t uniqueLines = index.size();
+    std::stringstream ss;
+    ss << "Memory image: " << liveLines << " non-zero lines stored as " << uniqueLines << " unique payloads"
+       << std::fixed << std::setprecision(2)
+       << " (dedup ratio " << (uniqueLines ? (double)liveLines / uniqueLines : 1.0) << ", "
+       << (double)(payloads.size() * (sizeof(DRAMdata) + sizeof(uint32_t))) / (1024*1024) << " MiB of payloads).";
+    msg::info(ss.str());
+}
+
+/*********************************/
+/* Class : CompressedMemoryImage */
+/*********************************/
+uint32_t CompressedMemoryImage::Slab::alloc() {
+    uint32_t record;
+    liveRecords++;
+
+    if (!freeRecords.empty()) {
+        record = freeRecords.back();
+        freeRecords.pop_back();
+        return record;
+    }
+
+    record = (uint32_t) (records.size() / recordSize);
+    msg::error(record > RECORD_MASK, "Memory image: exhausted the records of a compressed size class.");
+    records.resize(records.size() + recordSize);
+    return record;
+}
+
+void CompressedMemoryImage::Slab::release(uint32_t record) {
+    liveRecords--;
+    freeRecords.push_back(record);
+}
+
+CompressedMemoryImage::CompressedMemoryImage(const Config &configs) : MemoryImage(configs) {
+    rows = (uint32_t **) calloc(row_count(), sizeof(uint32_t *));
+    msg::error(rows == nullptr, "Unable to allocate the row table for the memory image.");
+
+    slabs[int(LineClass::ZERO)].recordSize   = 0;
+    slabs[int(LineClass::REPEAT)].recordSize = sizeof(uint32_t);
+    slabs[int(LineClass::BDI)].recordSize    = sizeof(uint32_t) + 15 + 2; // Base, low byte and sign of each delta
+    slabs[int(LineClass::RAW)].recordSize    = sizeof(uint32_t) * 16;
+}
+
+CompressedMemoryImage::~CompressedMemoryImage() {
+    for (uint64_t row = 0; row < row_count(); row++) {
+        free(rows[row]);
+    }
+    free(rows);
+}
+
+/* Decompresses the line held by slot into dest */
+void CompressedMemoryImage::decode(uint32_t slot, DRAMdata &dest) {
+    auto lineClass = LineClass(slot >> CLASS_SHIFT);
+    uint8_t *record = slabs[int(lineClass)].at(slot & RECORD_MASK);
+
+    switch (int(lineClass)) {
+        case (int(LineClass::ZERO)):
+            memset(dest.data, 0, sizeof(dest.data));
+            break;
+        case (int(LineClass::REPEAT)): {
+            uint32_t word;
+            memcpy(&word, record, sizeof(word));
+            for (int fourbytes = 0; fourbytes < 16; fourbytes++) {
+                dest.data[fourbytes] = word;
+            }
+            break;
+        }
+        case (int(LineClass::BDI)): {
+            uint16_t signs;
+            memcpy(&dest.data[0], record, sizeof(uint32_t));
+            memcpy(&signs, record + sizeof(uint32_t) + 15, sizeof(signs));
+            for (int fourbytes = 1; fourbytes < 16; fourbytes++) {
+                dest.data[fourbytes] = record[sizeof(uint32_t) + fourbytes - 1]
+                                       | (((signs >> (fourbytes - 1)) & 1u) << 31);
+            }
+            BDI::decompress(dest.data);
+            break;
+        }
+        default:
+            memcpy(dest.data, record, sizeof(dest.data));
+    }
+}
+
+/* Compresses the line into a record of the smallest size class it fits in and returns its slot */
+uint32_t CompressedMemoryImage::store(const unsigned int data[16], unsigned int encoded) {
+    bool isRepeat = true, isZero = (data[0] == 0);
+    for (int fourbytes = 1; fourbytes < 16; fourbytes++) {
+        isRepeat = isRepeat && (data[fourbytes] == data[0]);
+    }
+    isZero = isZero && isRepeat;
+
+    LineClass lineClass = isZero ? LineClass::ZERO
+                          : isRepeat ? LineClass::REPEAT
+                          : BDI::is_compressible(data) ? LineClass::BDI
+                          : LineClass::RAW;
+
+    // Zero lines take no record, encoded or not
+    if (lineClass == LineClass::ZERO)
+        return ((uint32_t) LineClass::ZERO << CLASS_SHIFT) | (encoded ? ENCODED_BIT : 0);
+
+    Slab &slab = slabs[int(lineClass)];
+    uint32_t record = slab.alloc();
+    uint8_t *dest = slab.at(record);
+
+    switch (int(lineClass)) {
+        case (int(LineClass::REPEAT)):
+            memcpy(dest, &data[0], sizeof(uint32_t));
+            break;
+        case (int(LineClass::BDI)): {
+            unsigned int compressed[16];
+            uint16_t signs = 0;
+            memcpy(compressed, data, sizeof(compressed));
+            BDI::compress(compressed);
+
+            memcpy(dest, &compressed[0], sizeof(uint32_t));
+            for (int fourbytes = 1; fourbytes < 16; fourbytes++) {
+                dest[sizeof(uint32_t) + fourbytes - 1] = (uint8_t) (compressed[fourbytes] & 0xFF);
+                signs |= (uint16_t) ((compressed[fourbytes] >> 31) << (fourbytes - 1));
+            }
+            memcpy(dest + sizeof(uint32_t) + 15, &signs, sizeof(signs));
+            break;
+        }
+        default:
+            memcpy(dest, data, sizeof(uint32_t) * 16);
+    }
+
+    return ((uint32_t) lineClass << CLASS_SHIFT) | (encoded ? ENCODED_BIT : 0) | record;
+}
+
+/* Allocates the slots of a row on its first write, compressing its lines from the snapshot if one is loaded */
+uint32_t *CompressedMemoryImage::materialize_row(uint64_t row) {
+    auto *slots = (uint32_t *) calloc(structCount[int(Level::COLUMN)], sizeof(uint32_t));
+    msg::error(slots == nullptr, "Unable to allocate a row for the memory image.");
+
+    const DRAMdata *snapshotRow = snapshot_row(row);
+    if (snapshotRow != nullptr) {
+        for (uint64_t col = 0; col < structCount[int(Level::COLUMN)]; col++) {
+            slots[col] = store(snapshotRow[col].data, is_encoded(encoded_bitmap(snapshotRow), col));
+        }
+    }
+
+    rows[row] = slots;
+    return slots;
+}
+
+const DRAMdata *CompressedMemoryImage::row_contents(uint64_t row, DRAMdata *buffer) {
+    if (rows[row] == nullptr)
+        return snapshot_row(row);
+
+    uint64_t *bitmap = encoded_bitmap(buffer);
+    memset(bitmap, 0, bitmapWords * sizeof(uint64_t));
+
+    for (uint64_t col = 0; col < structCount[int(Level::COLUMN)]; col++) {
+        if (rows[row][col] == 0)
+            buffer[col] = ZERO_LINE;
+        else
+            decode(rows[row][col], buffer[col]);
+        set_encoded(bitmap, col, rows[row][col] & ENCODED_BIT);
+    }
+    return buffer;
+}
+
+const DRAMdata &CompressedMemoryImage::read(const MappedAdd &add, unsigned int &encoded) {
+    uint32_t *row = rows[row_index(add)];
+
+    if (row == nullptr)
+        return snapshot_line(add, encoded);
+
+    encoded = (row[add.col] & ENCODED_BIT) ? 1 : 0;
+    if (row[add.col] == 0)
+        return ZERO_LINE;
+
+    decode(row[add.col], line);
+    return line;
+}
+
+void CompressedMemoryImage::write(const MappedAdd &add, const unsigned int data[16], unsigned int encoded) {
+    uint64_t rowIndex = row_index(add);
+    uint32_t *row = (rows[rowIndex] == nullptr) ? materialize_row(rowIndex) : rows[rowIndex];
+
+    // Release the record of the line being overwritten, zero lines have none
+    uint32_t &slot = row[add.col];
+    if (LineClass(slot >> CLASS_SHIFT) != LineClass::ZERO)
+        slabs[slot >> CLASS_SHIFT].release(slot & RECORD_MASK);
+
+    slot = store(data, encoded);
+}
+
+void CompressedMemoryImage::print_stats() const {
+    const std::string className[int(LineClass::MAX)] = {"zero", "repeated", "BDI", "raw"};
+    uint64_t lines = 0, storedBytes = 0;
+    std::stringstream ss;
+
+    // Zero lines take no record, they are counted from the slots of the written rows
+    uint64_t zeroLines = 0;
+    for (uint64_t row = 0; row < row_count(); row++) {
+        for (uint64_t col = 0; rows[row] != nullptr && col < structCount[int(Level::COLUMN)]; col++) {
+            zeroLines += (LineClass(rows[row][col] >> CLASS_SHIFT) == LineClass::ZERO);
+        }
+    }
+
+    ss << "Memory image: ";
+    for (int lineClass = 0; lineClass < int(LineClass::MAX); lineClass++) {
+        auto &slab = slabs[lineClass];
+        uint64_t classLines = lineClass == int(LineClass::ZERO) ? zeroLines : slab.liveRecords;
+        lines += classLines;
+        storedBytes += slab.liveRecords * slab.recordSize;
+        ss << classLines << " " << className[lineClass] << ", ";
+    }
+    ss << "lines stored in " << std::fixed << std::setprecision(2) << (double)storedBytes / (1024*1024) << " MiB"
+       << " (compression ratio " << (storedBytes ? (double)(lines * sizeof(DRAMdata)) / storedBytes : 1.0) << ").";
+    msg::info(ss.str());
+}
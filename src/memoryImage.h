@@ -0,0 +1,285 @@
+/*
+
+MEMORYIMAGE.H
+
+VAMPIRE: Variation-Aware model of Memory Power Informed by Real Experiments
+https://github.com/CMU-SAFARI/VAMPIRE
+
+Copyright (c) SAFARI Research Group at Carnegie Mellon University and ETH Zürich
+Released under the MIT License
+
+*/
+
+#ifndef VAMPIRE_MEMORYIMAGE_H
+#define VAMPIRE_MEMORYIMAGE_H
+
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+#include "consts.h"
+#include "address.h"
+#include "config.h"
+#include "helper.h"
+
+/*
+ * Layout of a memory image snapshot on disk: the header, padded to SNAPSHOT_DATA_OFFSET, followed by every row of the
+ * device in channel-major order and in the same layout as MemoryImage keeps them in RAM. Snapshots can thus be mapped
+ * as is and addressed like FlatMemoryImage, rows that are zero are left as holes so that the file only occupies disk
+ * space for the rows holding data.
+ */
+struct SnapshotHeader {
+    char magic[8];                              // SNAPSHOT_MAGIC
+    uint32_t version;
+    uint32_t rowSize;                           // Bytes of a stored row, see MemoryImage
+    uint64_t structCount[int(Level::MAX)];      // Geometry of the device, must match the configuration
+};
+
+static const char SNAPSHOT_MAGIC[8]         = {'V', 'A', 'M', 'P', 'I', 'M', 'G', '\0'};
+static const uint32_t SNAPSHOT_VERSION      = 2;
+static const size_t SNAPSHOT_DATA_OFFSET    = 4096;
+
+/*
+ * Backing store for the contents of the DRAM, used by TraceType::WR to find the data returned by a RD.
+ * Lines that were never written read as zero, or as their value in the snapshot given to load().
+ *
+ * A stored row is its cache line aligned lines followed by a bitmap of the lines holding encoded data, padded to a
+ * multiple of a cache line so that rows can be laid out back to back.
+ */
+class MemoryImage {
+protected:
+    uint64_t structCount[int(Level::MAX)];
+    size_t bitmapWords;                         // # of 64-bit words in the encoded bitmap of a row
+    size_t rowSize;                             // Bytes of a stored row
+
+    const DRAMdata *snapshot = nullptr;         // Read-only mapping of the loaded snapshot, nullptr if none
+    std::vector<bool> snapshotRows;             // Rows of the loaded snapshot that are not a hole in its file
+
+    /* Index of the row containing add, rows are numbered channel-major */
+    uint64_t row_index(const MappedAdd &add) const {
+        return ((add.channel * structCount[int(Level::RANK)] + add.rank)
+                * structCount[int(Level::BANK)] + add.bank)
+                * structCount[int(Level::ROW)] + add.row;
+    }
+    uint64_t row_count() const;
+    size_t image_size() const {return row_count() * rowSize;};
+
+    /* Encoded bitmap of a stored row */
+    uint64_t *encoded_bitmap(DRAMdata *row) const {return (uint64_t *) (row + structCount[int(Level::COLUMN)]);};
+    const uint64_t *encoded_bitmap(const DRAMdata *row) const {
+        return (const uint64_t *) (row + structCount[int(Level::COLUMN)]);
+    };
+    static unsigned int is_encoded(const uint64_t *bitmap, uint64_t col) {return (bitmap[col / 64] >> (col % 64)) & 1;};
+    static void set_encoded(uint64_t *bitmap, uint64_t col, unsigned int encoded) {
+        bitmap[col / 64] = (bitmap[col / 64] & ~(1ull << (col % 64))) | ((uint64_t) (encoded != 0) << (col % 64));
+    };
+
+    /* Allocates a zeroed, cache line aligned row, released with free() */
+    DRAMdata *alloc_row() const;
+
+    /* Maps the rows of the snapshot at path after validating its header against the configured geometry */
+    void *map_snapshot(const std::string &path, bool writable);
+
+    /* Line at add in the snapshot, for rows that were not written since it was loaded */
+    const DRAMdata &snapshot_line(const MappedAdd &add, unsigned int &encoded) const;
+    const DRAMdata *snapshot_row(uint64_t row) const {
+        return (snapshot == nullptr || !snapshotRows[row]) ? nullptr
+               : (const DRAMdata *) ((const char *) snapshot + row * rowSize);
+    }
+
+    /* Stored form of the given row, either kept by the image or built in buffer, nullptr if the row reads as zero */
+    virtual const DRAMdata *row_contents(uint64_t row, DRAMdata *buffer) = 0;
+public:
+    explicit MemoryImage(const Config &configs);
+    virtual ~MemoryImage();
+
+    /* Returns the line stored at add, the reference is valid until the next call to the image */
+    virtual const DRAMdata &read(const MappedAdd &add, unsigned int &encoded) = 0;
+    virtual void write(const MappedAdd &add, const unsigned int data[16], unsigned int encoded) = 0;
+
+    /* Starts from the contents in the snapshot at path instead of zero, must be called before the first write */
+    virtual void load(const std::string &path);
+    /* Writes the current contents as a snapshot to path */
+    void dump(const std::string &path);
+
+    virtual void print_stats() const {};
+};
+
+/*
+ * Materializes a row on its first write, reads of untouched rows return a shared zero line. Memory used is thus
+ * proportional to the number of rows touched by the trace instead of the size of the device.
+ */
+class SparseMemoryImage : public MemoryImage {
+private:
+    DRAMdata **rows;                // One entry per row of the device, nullptr until the row is written
+    uint64_t materializedRows = 0;
+
+    const DRAMdata *row_contents(uint64_t row, DRAMdata *buffer) override;
+public:
+    explicit SparseMemoryImage(const Config &configs);
+    ~SparseMemoryImage() override;
+
+    const DRAMdata &read(const MappedAdd &add, unsigned int &encoded) override;
+    void write(const MappedAdd &add, const unsigned int data[16], unsigned int encoded) override;
+
+    void print_stats() const override;
+};
+
+/*
+ * SparseMemoryImage with a bound on the RAM holding rows. Rows live in a fixed pool of frames, when the pool is full the
+ * CLOCK algorithm picks a row that was not accessed recently and writes it to an unlinked spill file if it was
+ * modified. Spilled rows are read back on their next access, so any footprint runs within the given limit.
+ */
+class SpillingMemoryImage : public MemoryImage {
+private:
+    static const uint32_t NONE = UINT32_MAX;
+
+    struct RowEntry {
+        uint32_t frame = NONE;              // Frame holding the row, NONE if not resident
+        uint32_t spillSlot = NONE;          // Slot of the row in the spill file, NONE if never spilled
+    };
+    struct FrameEntry {
+        uint64_t row;
+        bool referenced;                    // Accessed since the clock hand last passed
+        bool dirty;                         // Modified since read from the spill file
+    };
+
+    RowEntry *rows;
+    char *frames;
+    std::vector<FrameEntry> frameTable;     // Frames handed out so far, at most maxFrames
+    uint32_t maxFrames;
+    uint32_t clockHand = 0;
+
+    int spillFd;
+    uint32_t spillSlots = 0;
+
+    uint64_t faults = 0, evictions = 0, writeBacks = 0;
+
+    DRAMdata *frame_data(uint32_t frame) {return (DRAMdata *) (frames + (uint64_t) frame * rowSize);};
+    uint32_t evict();
+    DRAMdata *fault_in(uint64_t row);
+
+    const DRAMdata *row_contents(uint64_t row, DRAMdata *buffer) override;
+public:
+    SpillingMemoryImage(const Config &configs, uint64_t memLimit);
+    ~SpillingMemoryImage() override;
+
+    const DRAMdata &read(const MappedAdd &add, unsigned int &encoded) override;
+    void write(const MappedAdd &add, const unsigned int data[16], unsigned int encoded) override;
+
+    void print_stats() const override;
+};
+
+/*
+ * Keeps every row of the device back to back in one anonymous mapping, so a lookup is a few multiply-adds with no
+ * dependent loads. Pages are only backed once written (MAP_NORESERVE) and transparent huge pages are requested to keep
+ * the TLB footprint small, allocation and teardown are a single mmap/munmap.
+ */
+class FlatMemoryImage : public MemoryImage {
+private:
+    char *mapping;
+    size_t mappingSize;
+    std::vector<bool> writtenRows;     // Rows written since the start, only these and the snapshot ones are dumped
+
+    DRAMdata *row_at(uint64_t row) {return (DRAMdata *) (mapping + row * rowSize);};
+
+    const DRAMdata *row_contents(uint64_t row, DRAMdata *buffer) override;
+public:
+    explicit FlatMemoryImage(const Config &configs);
+    ~FlatMemoryImage() override;
+
+    const DRAMdata &read(const MappedAdd &add, unsigned int &encoded) override;
+    void write(const MappedAdd &add, const unsigned int data[16], unsigned int encoded) override;
+
+    void load(const std::string &path) override;
+
+    void print_stats() const override;
+};
+
+/*
+ * Stores each distinct line once. Every written slot holds a 32-bit handle to a reference counted payload, so traces
+ * that repeatedly write the same patterns (zero pages, memset fills, copies of a struct) only pay for the unique ones.
+ * Handle 0 is reserved for the zero line and is never stored.
+ */
+class DedupMemoryImage : public MemoryImage {
+private:
+    /* Hash and equality of payloads referred by their handle */
+    struct PayloadHash {
+        const std::vector<DRAMdata> *payloads;
+        size_t operator()(uint32_t handle) const;
+    };
+    struct PayloadEqual {
+        const std::vector<DRAMdata> *payloads;
+        bool operator()(uint32_t lhs, uint32_t rhs) const;
+    };
+
+    uint64_t **rows;                        // Encoded bitmap and handles of each row, nullptr until the row is written
+    std::vector<DRAMdata> payloads;         // Unique lines indexed by their handle
+    std::vector<uint32_t> refCount;
+    std::vector<uint32_t> freeHandles;      // Handles of payloads whose reference count dropped to 0
+    std::unordered_set<uint32_t, PayloadHash, PayloadEqual> index;
+
+    uint64_t liveLines = 0;                 // # of slots holding a non-zero line
+
+    uint32_t *handles(uint64_t *row) const {return (uint32_t *) (row + bitmapWords);};
+
+    uint32_t acquire(const unsigned int data[16]);
+    void release(uint32_t handle);
+
+    const DRAMdata *row_contents(uint64_t row, DRAMdata *buffer) override;
+public:
+    explicit DedupMemoryImage(const Config &configs);
+    ~DedupMemoryImage() override;
+
+    const DRAMdata &read(const MappedAdd &add, unsigned int &encoded) override;
+    void write(const MappedAdd &add, const unsigned int data[16], unsigned int encoded) override;
+
+    void print_stats() const override;
+};
+
+/*
+ * Keeps lines compressed at rest. All-zero lines take no space, lines repeating a single word take 4 bytes and lines
+ * that are BDI compressible (see src/mapping.cpp) take 21 bytes, every other line is stored as is. Each size class has
+ * its own slab of fixed size records, a slot holds the class and the record of its line. RDs decompress into a buffer.
+ */
+class CompressedMemoryImage : public MemoryImage {
+private:
+    enum class LineClass {ZERO, REPEAT, BDI, RAW, MAX};
+
+    /* Records of one size class, records of overwritten lines are reused */
+    struct Slab {
+        size_t recordSize;
+        std::vector<uint8_t> records;
+        std::vector<uint32_t> freeRecords;
+        uint64_t liveRecords = 0;
+
+        uint32_t alloc();
+        void release(uint32_t record);
+        uint8_t *at(uint32_t record) {return records.data() + record * recordSize;};
+    };
+
+    /* Slot layout: <class (2 bits)><encoded (1 bit)><record (29 bits)>, 0 is the zero line */
+    static const uint32_t CLASS_SHIFT   = 30;
+    static const uint32_t ENCODED_BIT   = 1u << 29;
+    static const uint32_t RECORD_MASK   = ENCODED_BIT - 1;
+
+    uint32_t **rows;                        // Slots of the lines of each row, nullptr until the row is written
+    Slab slabs[int(LineClass::MAX)];
+    DRAMdata line;                          // Decompressed line returned by read()
+
+    void decode(uint32_t slot, DRAMdata &dest);
+    uint32_t store(const unsigned int data[16], unsigned int encoded);
+    uint32_t *materialize_row(uint64_t row);
+
+    const DRAMdata *row_contents(uint64_t row, DRAMdata *buffer) override;
+public:
+    explicit CompressedMemoryImage(const Config &configs);
+    ~CompressedMemoryImage() override;
+
+    const DRAMdata &read(const MappedAdd &add, unsigned int &encoded) override;
+    void write(const MappedAdd &add, const unsigned int data[16], unsigned int encoded) override;
+
+    void print_stats() const override;
+};
+
+#endif //VAMPIRE_MEMORYIMAGE_H
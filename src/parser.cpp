@@ -10,7 +10,15 @@ Released under the MIT License
 
 */
 
+#include <algorithm>
 #include <assert.h>
+#include <cerrno>
+#include <chrono>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "directStream.h"
 #include "parser.h"
 
 /******************/
@@ -20,9 +28,116 @@ Parser::Parser() {
     DELIM = ",";
 }
 Parser::~Parser() {
-    file->close();
-    delete file;
+    if (mapping != nullptr)
+        munmap(mapping, mappingSize);
+    delete stream;
+    if (fd >= 0)
+        close(fd);
 }
+
+void Parser::open_trace() {
+    struct stat fileStat = {};
+
+    fd = (filename == TRACE_STDIN) ? dup(STDIN_FILENO) : open(filename.c_str(), O_RDONLY);
+    if (fd < 0 || fstat(fd, &fileStat) != 0)
+        msg::error("Unable to open trace file `" + filename + "'.");
+
+    msg::info((filename == TRACE_STDIN) ? "Reading trace from standard input" : "Using trace file: `" + filename + "'");
+
+    // A followed trace may be empty or partly written for now, it is read as is through the buffer
+    if (follow) {
+        buffer.resize(BUFFER_SIZE);
+        cursor = end = buffer.data();
+        return;
+    }
+
+    // Traces larger than the page cache are read around it, compressed or not
+    if (directIO && S_ISREG(fileStat.st_mode)) {
+        auto *direct = new DirectStream(filename);
+        msg::info("Reading the trace with " + direct->engine());
+        open_stream(direct);
+        buffer.resize(BUFFER_SIZE);
+        cursor = end = buffer.data();
+        return;
+    }
+
+    // Plain regular files are mapped as a whole and read ahead by the kernel, anything else is read through the buffer
+    uint8_t head[TraceStream::TAR_BLOCK_SIZE];
+    bool isPlain = S_ISREG(fileStat.st_mode)
+                   && TraceStream::detect(head, (size_t) std::max<ssize_t>(pread(fd, head, sizeof(head), 0), 0))
+                      == TraceFormat::PLAIN;
+    if (isPlain && fileStat.st_size > 0) {
+        mappingSize = (size_t) fileStat.st_size;
+        void *map = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            mapping = (uint8_t *) map;
+            madvise(mapping, mappingSize, MADV_SEQUENTIAL);
+            cursor = mapping;
+            end = mapping + mappingSize;
+            return;
+        }
+    }
+
+    if (!isPlain)
+        open_stream(new FdStream(fd));
+    buffer.resize(BUFFER_SIZE);
+    cursor = end = buffer.data();
+}
+
+void Parser::open_stream(TraceStream *source) {
+    std::vector<TraceFormat> formats;
+    stream = TraceStream::open(source, formats);
+
+    if (!formats.empty()) {
+        std::string layers;
+        for (auto format : formats) {
+            layers += (layers.empty() ? "" : " > ") + traceFormatString[int(format)];
+        }
+        msg::info("Reading " + layers + " trace");
+    }
+}
+
+bool Parser::fill(size_t bytes) {
+    if ((size_t) (end - cursor) >= bytes)
+        return true;
+    if (mapping != nullptr || buffer.empty())
+        return false;
+
+    // Move the partial command to the front of the buffer, grow it if the command does not fit and read until it is
+    // full or the input ends
+    size_t remaining = end - cursor;
+    consumed += cursor - buffer.data();
+    memmove(buffer.data(), cursor, remaining);
+    if (bytes > buffer.size())
+        buffer.resize(std::max(bytes, 2 * buffer.size()));
+    cursor = buffer.data();
+    end = cursor + remaining;
+
+    // Stop as soon as the command is available, so that commands written to a pipe are estimated as they arrive
+    while ((size_t) (end - cursor) < bytes) {
+        ssize_t readBytes;
+        if (stream != nullptr) {
+            readBytes = (ssize_t) stream->read((uint8_t *) end, buffer.data() + buffer.size() - end);
+        } else {
+            readBytes = read(fd, (void *) end, buffer.data() + buffer.size() - end);
+            if (readBytes < 0 && errno == EINTR)
+                continue;
+            msg::error(readBytes < 0, "Unable to read trace file `" + filename + "'.");
+        }
+        if (readBytes == 0) {
+            // A followed trace ends with its end-of-input marker, wait for the writer until then
+            if (!follow || (followTimeout > 0 && followIdle >= followTimeout))
+                break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(FOLLOW_POLL_INTERVAL));
+            followIdle += FOLLOW_POLL_INTERVAL;
+            continue;
+        }
+        followIdle = 0;
+        end += readBytes;
+    }
+    return (size_t) (end - cursor) >= bytes;
+}
+
 std::vector<std::string> Parser::splitStrAt(const std::string& str, const std::string& delim) {
     std::vector<std::string> tokens;
     size_t prev = 0, pos = 0;
@@ -41,6 +156,55 @@ bool verify_cmd(MappedAdd &add, CommandType &cmdType) {
     return true; // TODO: implement this
 }
 
+/* Commands are parsed in place one after the other, so that fields a command does not set are carried over from the
+ * previous one exactly as with repeated calls to parse() */
+size_t Parser::parse_batch(Command *out, size_t n) {
+    bool wasDataRead;
+    size_t parsed = 0;
+
+    for (; parsed < n; parsed++) {
+        if (parsed > 0)
+            out[parsed] = out[parsed - 1];
+        else
+            out[parsed] = lastParsed;
+        out[parsed].add.reset();
+
+        if (!parse(wasDataRead, out[parsed]))
+            break;
+        out[parsed].hasData = wasDataRead;
+    }
+
+    if (parsed > 0)
+        lastParsed = out[parsed - 1];
+    return parsed;
+}
+
+uint64_t Parser::position() const {
+    return (mapping != nullptr) ? cursor - mapping : consumed + (cursor - buffer.data());
+}
+
+bool Parser::isMapped() const {
+    return mapping != nullptr;
+}
+
+bool Parser::seek(uint64_t offset, const Command &previous) {
+    if (mapping == nullptr || offset > mappingSize)
+        return false;
+
+    cursor = mapping + offset;
+    lastParsed = previous;
+    return true;
+}
+
+void Parser::setFollow(bool follow, unsigned int timeout) {
+    this->follow = follow;
+    followTimeout = timeout;
+}
+
+void Parser::setDirectIO(bool directIO) {
+    this->directIO = directIO;
+}
+
 std::string Parser::getFilename() {
     return filename;
 }
@@ -53,133 +217,560 @@ void Parser::setTraceType(TraceType traceType) {
     Parser::traceType = traceType;
 }
 
+void Parser::setSelection(const Selection &selection) {
+    this->selection = selection;
+}
+
+uint64_t Parser::getSkippedUntil() const {
+    return skippedUntil;
+}
+
 /***********************/
 /*  Class : BinParser  */
 /***********************/
+BinParser::~BinParser() {
+    delete layout;
+}
+
 void BinParser::setFilename(std::string filename) {
     this->filename = filename;
+    open_trace();
 
+    if (!fill(sizeof(TRACE_MAGIC)) || memcmp(cursor, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0)
+        return;
 
-    file = new std::ifstream(filename, std::ifstream::binary);
+    msg::error(!fill(sizeof(TraceHeader)), "Binary trace header is truncated.");
+    memcpy(&header, cursor, sizeof(TraceHeader));
+    layout = new TraceLayout(header);
+    msg::error(!fill(header.headerSize), "Binary trace header is truncated.");
+    cursor += header.headerSize;
 
-    if (file->bad())
-        msg::error("Bad trace file");
-
-    msg::info("Using trace file: `" + filename + "'");
+    msg::info("Binary trace version " + std::to_string(header.version) + ", "
+              + (header.commandCount ? std::to_string(header.commandCount) : "unknown #") + " of commands, written for "
+              + (header.traceType < int(TraceType::MAX) ? traceTypeString[header.traceType] : "an unknown") + " model");
+}
 
-    if (!file->is_open())
-        msg::error("Unable to open trace file `" + filename + "'.");
+/* Version 2 traces only hold the data their model reads, warn if the model that will use the trace reads more */
+void BinParser::setTraceType(TraceType traceType) {
+    Parser::setTraceType(traceType);
 
-    std::ifstream in(filename, std::ifstream::ate | std::ifstream::binary);
-    this->fileSize = in.tellg();
+    auto needsData = [] (int type) {return type == int(TraceType::WR) || type == int(TraceType::RD_WR);};
+    if (layout != nullptr && needsData(int(traceType))
+        && (!needsData(header.traceType) || (traceType == TraceType::RD_WR && header.traceType != int(TraceType::RD_WR))))
+        msg::warning("Binary trace was written for the " + traceTypeString[header.traceType] + " model, data of the "
+                     + traceTypeString[int(traceType)] + " model may be missing.");
 }
 
 void BinParser::parse_data(uint32_t data[16]) {
     msg::error("Not implemented");
 }
 
-/* Parses a single command from the trace file
+/* Decodes a single command, returns false at the end of the trace
  *
  * Command format (`<>' represents a 64 bit word):
  *
  * 1. <Timestamp(64bits)><(zero padding), CommandType(3bit), channel(2bits), rank(2bits), bank(3bits), row(16bits), col(7bits)>
  * 2. <Timestamp(64bits)><(zero padding), CommandType(3bit), channel(2bits), rank(2bits), bank(3bits), row(16bits), col(7bits)><data0><data1>...<data7>
  */
+bool BinParser::decode(Command &cmd) {
+    uint64_t fields;
+
+    // Commands outside of the selection are skipped without copying their data
+    while (true) {
+        // Return false if file is completely read
+        if (endMarked)
+            return false;
+        if (!fill(HEADER_SIZE)) {
+            msg::error(cursor != end, "Incorrect format used for the trace file.");
+            return false;
+        }
+
+        memcpy(&cmd.issueTime, cursor, sizeof(uint64_t));
+        memcpy(&fields, cursor + sizeof(uint64_t), sizeof(uint64_t));
+
+        cmd.add.col     = fields & 0x7F;
+        fields = fields >> 7;
+
+        cmd.add.row     = fields & 0xFFFF;
+        fields = fields >> 16;
+
+        cmd.add.bank    = fields & 0x7;
+        fields = fields >> 3;
+
+        cmd.add.rank    = fields & 0x3;
+        fields = fields >> 2;
+
+        cmd.add.channel = fields & 0x3;
+        fields = fields >> 2;
+
+        // Use rest of bits in the fields for identifying cmd.type
+        switch (fields & 0b111) {
+            case (0b000):
+                cmd.type = CommandType::RD;
+                break;
+            case (0b001):
+                cmd.type = CommandType::WR;
+                break;
+            case (0b010):
+                cmd.type = CommandType::ACT;
+                break;
+            case (0b011):
+                cmd.type = CommandType::PRE;
+                break;
+            case (0b100):
+                cmd.type = CommandType::RDA;
+                break;
+            case (0b101):
+                cmd.type = CommandType::WRA;
+                break;
+            case (END_TYPE):
+                cursor += HEADER_SIZE;
+                endMarked = true;
+                return false;
+            default:
+                std::stringstream errorStr;
+                errorStr << "Unknown command Type at: " << consumed + (cursor - (mapping ? mapping : buffer.data()))
+                         << " byte, cmd.issueTime: " << cmd.issueTime << std::endl;
+                msg::error(errorStr.str());
+        }
+        cursor += HEADER_SIZE;
+
+        bool isIOCmd = cmd.type == CommandType::WR || cmd.type == CommandType::RD;
+        bool isWriteCmd = cmd.type == CommandType::WR;
+        bool hasData = (isWriteCmd && traceType == TraceType::WR) || (isIOCmd && traceType == TraceType::RD_WR);
+
+        if (!selection.matches(cmd.add.channel, cmd.add.rank, cmd.add.bank)) {
+            msg::error(hasData && !fill(DATA_SIZE), "Incorrect format used for the trace file.");
+            cursor += hasData ? DATA_SIZE : 0;
+            skippedUntil = std::max(skippedUntil, cmd.issueTime);
+            continue;
+        }
+
+        if (hasData){ /* Also get the data to be written */
+            msg::error(!fill(DATA_SIZE), "Incorrect format used for the trace file.");
+            memcpy(cmd.data, cursor, DATA_SIZE);
+            cursor += DATA_SIZE;
+            cmd.hasData = true;
+        } else {
+            memset(cmd.data, 0, DATA_SIZE);
+            cmd.hasData = false;
+        }
+
+        return true;
+    }
+}
+
+/* Decodes a single command of a version 2 trace, returns false at the end of the trace */
+bool BinParser::decode_v2(Command &cmd) {
+    // Commands outside of the selection are skipped
+    while (true) {
+        // The last commands of the trace may be shorter than the largest possible command
+        if (endMarked || (!fill(TRACE_MAX_VARINT_SIZE + layout->packedBytes) && cursor == end))
+            return false;
+
+        const uint8_t *pos = cursor;
+        uint64_t delta = 0;
+        unsigned int shift = 0;
+        do {
+            msg::error(pos == end || shift >= 64, "Incorrect format used for the trace file.");
+            delta |= (uint64_t) (*pos & 0x7F) << shift;
+            shift += 7;
+        } while (*pos++ & 0x80);
+
+        uint64_t packed = 0;
+        msg::error((size_t) (end - pos) < layout->packedBytes, "Incorrect format used for the trace file.");
+        memcpy(&packed, pos, layout->packedBytes);
+        cursor = pos + layout->packedBytes;
+
+        cmd.issueTime = lastIssueTime + zigzag_decode(delta);
+        lastIssueTime = cmd.issueTime;
+
+        cmd.add.channel = (packed >> layout->shift[int(Level::CHANNEL)]) & layout->mask[int(Level::CHANNEL)];
+        cmd.add.rank    = (packed >> layout->shift[int(Level::RANK)]) & layout->mask[int(Level::RANK)];
+        cmd.add.bank    = (packed >> layout->shift[int(Level::BANK)]) & layout->mask[int(Level::BANK)];
+        cmd.add.row     = (packed >> layout->shift[int(Level::ROW)]) & layout->mask[int(Level::ROW)];
+        cmd.add.col     = (packed >> layout->shift[int(Level::COLUMN)]) & layout->mask[int(Level::COLUMN)];
+
+        unsigned int type = (packed >> layout->typeShift) & ((1u << TRACE_TYPE_BITS) - 1);
+        if (type == TRACE_END_TYPE) {
+            endMarked = true;
+            return false;
+        }
+        if (type >= (unsigned int) CommandType::MAX)
+            msg::error("Unknown command Type at: " + std::to_string(consumed + (cursor - (mapping ? mapping : buffer.data())))
+                       + " byte, cmd.issueTime: " + std::to_string(cmd.issueTime));
+        cmd.type = (CommandType) type;
+
+        switch ((packed >> (layout->typeShift + TRACE_TYPE_BITS + 1)) & 0b11) {
+            case (int(TraceData::ZERO)):
+                memset(lastData, 0, DATA_SIZE);
+                break;
+            case (int(TraceData::PAYLOAD)):
+                msg::error(!fill(DATA_SIZE), "Incorrect format used for the trace file.");
+                memcpy(lastData, cursor, DATA_SIZE);
+                cursor += DATA_SIZE;
+                break;
+            case (int(TraceData::PREVIOUS)):
+                break;
+            default:
+                msg::error("Unknown data source for command at time: " + std::to_string(cmd.issueTime));
+        }
+
+        // The data is still decoded as the next commands may repeat it
+        if (!selection.matches(cmd.add.channel, cmd.add.rank, cmd.add.bank)) {
+            skippedUntil = std::max(skippedUntil, cmd.issueTime);
+            continue;
+        }
+        memcpy(cmd.data, lastData, DATA_SIZE);
+
+        // Data only counts as read for the commands whose energy depends on it in the model in use, as in ASCII traces
+        bool isRdCmd = cmd.type == CommandType::RD || cmd.type == CommandType::RDA;
+        bool isWrCmd = cmd.type == CommandType::WR || cmd.type == CommandType::WRA;
+        bool readData = ((isRdCmd || isWrCmd) && traceType == TraceType::RD_WR) || (isWrCmd && traceType == TraceType::WR);
+        cmd.hasData = readData && ((packed >> (layout->typeShift + TRACE_TYPE_BITS)) & 1);
+
+        return true;
+    }
+}
 
 bool BinParser::parse(bool &wasDataRead, Command &cmd) {
-    dbgstream << ", tellg: " << file->tellg();
+    if (!(layout != nullptr ? decode_v2(cmd) : decode(cmd)))
+        return false;
+
+    wasDataRead = cmd.hasData;
+    return true;
+}
 
-    // Return false if file is completely read
-    if (file->tellg() == fileSize)
+size_t BinParser::parse_batch(Command *out, size_t n) {
+    size_t parsed = 0;
+    if (layout != nullptr) {
+        while (parsed < n && decode_v2(out[parsed])) {
+            parsed++;
+        }
+    } else {
+        while (parsed < n && decode(out[parsed])) {
+            parsed++;
+        }
+    }
+    return parsed;
+}
+
+bool BinParser::seek(uint64_t offset, const Command &previous) {
+    if (!Parser::seek(offset, previous))
         return false;
 
-    if (file->tellg() == -1)
-        msg::error("Incorrect format used for the trace file.");
+    lastIssueTime = previous.issueTime;
+    memcpy(lastData, previous.data, DATA_SIZE);
+    return true;
+}
 
-    auto *time = new uint64_t(0);
-    auto time_a = new char[sizeof(time)];
-    file->read(time_a, sizeof(time));
+/***********************/
+/* Class : AsyncParser */
+/***********************/
+AsyncParser::AsyncParser(Parser *source, size_t depth, size_t batchSize)
+        : source(source), ring(depth), batchSize(batchSize) {
+    filename = source->getFilename();
+    traceType = source->getTraceType();
 
-    cmd.issueTime = *(uint64_t*)(time_a);
+    for (auto &batch : ring) {
+        batch.cmds.resize(batchSize);
+    }
+    decoder = std::thread(&AsyncParser::decode_loop, this);
+}
 
-    auto bytes_read_c = new char[sizeof(uint64_t)];
+AsyncParser::~AsyncParser() {
+    stop.store(true);
+    wake(batchDrained);
+    decoder.join();
+    delete source;
+}
 
-    file->read(bytes_read_c, sizeof(bytes_read_c));
+void AsyncParser::setFilename(std::string filename) {
+    msg::error("The trace of an asynchronous parser is set through its source parser.");
+}
 
-    auto bytes_read = *((uint64_t*)bytes_read_c);
+void AsyncParser::parse_data(uint32_t data[16]) {
+    msg::error("Not implemented");
+}
 
-    cmd.add.col = bytes_read & 0x7F;
-    bytes_read = bytes_read >> 7;
+/*
+ * The indices and the sleepers are stored and loaded sequentially consistent, so that either the sleeper sees the index
+ * moved before it sleeps, or the thread moving it sees the sleeper and wakes it.
+ */
+template <typename Ready>
+void AsyncParser::wait_for(std::condition_variable &moved, Ready ready) {
+    for (int spin = 0; spin < PARSE_SPIN; spin++) {
+        if (ready())
+            return;
+        std::this_thread::yield();
+    }
 
-    cmd.add.row     = bytes_read & 0xFFFF;
-    bytes_read = bytes_read >> 16;
+    std::unique_lock<std::mutex> guard(lock);
+    sleepers++;
+    moved.wait(guard, ready);
+    sleepers--;
+}
 
-    cmd.add.bank    = bytes_read & 0x7;
-    bytes_read = bytes_read >> 3;
+void AsyncParser::wake(std::condition_variable &moved) {
+    if (sleepers.load() == 0)
+        return;
 
-    cmd.add.rank    = bytes_read & 0x3;
-    bytes_read = bytes_read >> 2;
+    std::lock_guard<std::mutex> guard(lock);
+    moved.notify_one();
+}
 
-    cmd.add.channel = bytes_read & 0x3;
-    bytes_read = bytes_read >> 2;
+/* Body of the decoding thread, fills the batches of the ring until the end of the trace */
+void AsyncParser::decode_loop() {
+    uint64_t filled = 0;
+    size_t parsed;
 
-    // Use rest of bits in the bytes_read for identifying cmd.type
-    switch (bytes_read & 0b111) {
-        case (0b000):
-            cmd.type = CommandType::RD;
-            break;
-        case (0b001):
-            cmd.type = CommandType::WR;
-            break;
-        case (0b010):
-            cmd.type = CommandType::ACT;
-            break;
-        case (0b011):
-            cmd.type = CommandType::PRE;
-            break;
-        case (0b100):
-            cmd.type = CommandType::RDA;
-            break;
-        case (0b101):
-            cmd.type = CommandType::WRA;
+    do {
+        // Wait for the estimation thread to drain a batch if the ring is full
+        wait_for(batchDrained, [this, filled] {return stop.load() || filled - tail.load() < ring.size();});
+        if (stop.load(std::memory_order_relaxed))
+            return;
+
+        Batch &batch = ring[filled % ring.size()];
+        parsed = source->parse_batch(batch.cmds.data(), batchSize);
+        batch.size = parsed;
+        batch.skippedUntil = source->getSkippedUntil();
+
+        head.store(++filled);
+        wake(batchFilled);
+    } while (parsed > 0);
+}
+
+size_t AsyncParser::parse_batch(Command *out, size_t n) {
+    size_t copied = 0;
+    uint64_t drained = tail.load(std::memory_order_relaxed);
+
+    while (copied < n) {
+        // Wait for the decoding thread to fill the next batch
+        wait_for(batchFilled, [this, drained] {return drained != head.load();});
+
+        Batch &batch = ring[drained % ring.size()];
+        skippedUntil = batch.skippedUntil;
+        if (batch.size == 0)
+            break; // End of the trace, the empty batch stays in the ring for any later call
+
+        size_t count = std::min(n - copied, batch.size - batchPos);
+        std::copy(batch.cmds.begin() + batchPos, batch.cmds.begin() + batchPos + count, out + copied);
+        copied += count;
+        batchPos += count;
+
+        if (batchPos == batch.size) {
+            batchPos = 0;
+            tail.store(++drained);
+            wake(batchDrained);
+        }
+
+        // Hand out what is available rather than waiting for a full request
+        if (drained == head.load(std::memory_order_acquire))
             break;
-        default:
-            std::stringstream errorStr;
-            errorStr << "Unknown command Type at: " << file->tellg() << " byte, cmd.issueTime: " << cmd.issueTime << std::endl;
-            msg::error(errorStr.str());
     }
+    return copied;
+}
 
-    // Reset cmd.data
-    for (int i = 0;i < 16; i++)
-        cmd.data[i] = 0;
+/* The decoding thread is already running, its source has to be seeked before it is handed over */
+bool AsyncParser::seek(uint64_t offset, const Command &previous) {
+    return false;
+}
 
-    bool isIOCmd = cmd.type == CommandType::WR || cmd.type == CommandType::RD;
-    bool isWriteCmd = cmd.type == CommandType::WR;
+bool AsyncParser::parse(bool &wasDataRead, Command &cmd) {
+    if (parse_batch(&cmd, 1) == 0)
+        return false;
 
-    if ((isWriteCmd && traceType == TraceType::WR) || (isIOCmd && traceType == TraceType::RD_WR)){ /* Also get the data to be written */
-        char data_c[sizeof(uint32_t) * 16]; // 64 bytes
-        file->read(data_c, sizeof(uint32_t)*16);
-        auto data = (uint32_t*)data_c;
+    wasDataRead = cmd.hasData;
+    return true;
+}
 
-        for (int i = 0; i < 16; i++) {
-            cmd.data[i] = data[i];
-        }
+/***********************/
+/* Class : DemuxParser */
+/***********************/
+DemuxParser::Stream::Stream(const std::string &filename, TraceType traceType, size_t batchSize) : ring(DEPTH) {
+    this->filename = filename;
+    this->traceType = traceType;
+    filling.reserve(batchSize);
+}
 
-        dbgstream << std::endl << "dataread: " << std::hex;
-        for (int i = 0; i < 16; i++) {
-            dbgstream << data[i];
-        }
-        dbgstream << std::dec << std::endl;
+void DemuxParser::Stream::setFilename(std::string filename) {
+    msg::error("The trace of a demultiplexed stream is set through its source parser.");
+}
 
-        wasDataRead = true;
+void DemuxParser::Stream::parse_data(uint32_t data[16]) {
+    msg::error("Not implemented");
+}
 
-    } else {
-        wasDataRead = false;
+size_t DemuxParser::Stream::parse_batch(Command *out, size_t n) {
+    std::unique_lock<std::mutex> guard(lock);
+    batchFilled.wait(guard, [this] {return head > tail;});
+
+    Batch &batch = ring[tail % ring.size()];
+    skippedUntil = batch.skippedUntil;
+    if (batch.cmds.empty())
+        return 0; // End of the trace, the empty batch stays in the ring for any later call
+
+    size_t count = std::min(n, batch.cmds.size() - batchPos);
+    std::copy(batch.cmds.begin() + batchPos, batch.cmds.begin() + batchPos + count, out);
+    batchPos += count;
+
+    if (batchPos == batch.cmds.size()) {
+        batchPos = 0;
+        tail++;
+        batchDrained.notify_one();
     }
+    return count;
+}
 
-    delete[] bytes_read_c;
-    delete[] time_a;
-    delete time;
+bool DemuxParser::Stream::parse(bool &wasDataRead, Command &cmd) {
+    if (parse_batch(&cmd, 1) == 0)
+        return false;
+
+    wasDataRead = cmd.hasData;
+    return true;
+}
+
+DemuxParser::DemuxParser(Parser &source, Level level, const uint64_t (&structCount)[int(Level::MAX)],
+                         uint64_t windowEnd, size_t batchSize)
+        : source(source), level(level), rankCount(structCount[int(Level::RANK)]), windowEnd(windowEnd),
+          batchSize(batchSize) {
+    uint64_t partitions = structCount[int(Level::CHANNEL)] * (level == Level::RANK ? rankCount : 1);
+
+    for (uint64_t partition = 0; partition < partitions; partition++) {
+        streams.push_back(new Stream(source.getFilename(), source.getTraceType(), batchSize));
+    }
+    demuxer = std::thread(&DemuxParser::demux_loop, this);
+}
+
+DemuxParser::DemuxParser(Parser &source, size_t copies, uint64_t windowEnd, size_t batchSize)
+        : source(source), level(Level::MAX), rankCount(1), windowEnd(windowEnd), batchSize(batchSize) {
+    for (size_t copy = 0; copy < copies; copy++) {
+        streams.push_back(new Stream(source.getFilename(), source.getTraceType(), batchSize));
+    }
+    demuxer = std::thread(&DemuxParser::demux_loop, this);
+}
+
+DemuxParser::~DemuxParser() {
+    for (auto *stream : streams) {
+        std::lock_guard<std::mutex> guard(stream->lock);
+        stream->stop = true;
+        stream->batchDrained.notify_all();
+    }
+    demuxer.join();
+
+    for (auto *stream : streams) {
+        delete stream;
+    }
+}
+
+/* Commands outside of the geometry go to the last partition, whose estimator rejects them */
+size_t DemuxParser::partition_of(const MappedAdd &add) const {
+    uint64_t partition = (level == Level::RANK) ? add.channel * rankCount + add.rank : add.channel;
+    return (size_t) std::min<uint64_t>(partition, streams.size() - 1);
+}
+
+bool DemuxParser::publish(size_t partition) {
+    Stream &stream = *streams[partition];
+
+    uint64_t skippedUntil = source.getSkippedUntil();
+    for (size_t other = 0; other < streams.size(); other++) {
+        if (other != partition)
+            skippedUntil = std::max(skippedUntil, streams[other]->lastIssueTime);
+    }
+
+    std::unique_lock<std::mutex> guard(stream.lock);
+    stream.batchDrained.wait(guard, [&stream] {return stream.head - stream.tail < stream.ring.size() || stream.stop;});
+    if (stream.stop)
+        return false;
+
+    // The slot at head was drained, its commands are recycled as the next batch to fill
+    Batch &batch = stream.ring[stream.head % stream.ring.size()];
+    batch.cmds.swap(stream.filling);
+    batch.skippedUntil = skippedUntil;
+    stream.head++;
+    stream.batchFilled.notify_one();
+    guard.unlock();
+
+    stream.filling.clear();
+    return true;
+}
+
+bool DemuxParser::route(size_t partition, const Command &cmd) {
+    Stream &stream = *streams[partition];
+    stream.filling.push_back(cmd);
+    stream.lastIssueTime = std::max(stream.lastIssueTime, cmd.issueTime);
+    return stream.filling.size() < batchSize || publish(partition);
+}
+
+/* Body of the demultiplexing thread, routes the commands of the trace to the streams of their partition */
+void DemuxParser::demux_loop() {
+    std::vector<Command> batch(batchSize);
+    bool windowEnded = false;
+    size_t parsed;
+
+    while (!windowEnded && (parsed = source.parse_batch(batch.data(), batchSize)) > 0) {
+        for (size_t pos = 0; pos < parsed; pos++) {
+            if (batch[pos].issueTime > windowEnd) {
+                windowEnded = true;
+                break;
+            }
+
+            if (level != Level::MAX) {
+                if (!route(partition_of(batch[pos].add), batch[pos]))
+                    return;
+                continue;
+            }
+            for (size_t copy = 0; copy < streams.size(); copy++) {
+                if (!route(copy, batch[pos]))
+                    return;
+            }
+        }
+    }
+
+    // Hand out the last commands of each stream, then the empty batch that ends it
+    for (size_t partition = 0; partition < streams.size(); partition++) {
+        if (!streams[partition]->filling.empty() && !publish(partition))
+            return;
+        if (!publish(partition))
+            return;
+    }
+}
+
+/*************************/
+/* Class : SegmentParser */
+/*************************/
+SegmentParser::SegmentParser(Parser *source, uint64_t count) : source(source), remaining(count) {
+    filename = source->getFilename();
+    traceType = source->getTraceType();
+}
+
+SegmentParser::~SegmentParser() {
+    delete source;
+}
+
+void SegmentParser::setFilename(std::string filename) {
+    msg::error("The trace of a segment is set through its source parser.");
+}
+
+void SegmentParser::parse_data(uint32_t data[16]) {
+    msg::error("Not implemented");
+}
+
+size_t SegmentParser::parse_batch(Command *out, size_t n) {
+    if (remaining == 0)
+        return 0;
+
+    size_t parsed = source->parse_batch(out, (size_t) std::min<uint64_t>(n, remaining));
+    remaining -= parsed;
+    skippedUntil = source->getSkippedUntil();
+    return parsed;
+}
+
+bool SegmentParser::parse(bool &wasDataRead, Command &cmd) {
+    if (parse_batch(&cmd, 1) == 0)
+        return false;
+
+    wasDataRead = cmd.hasData;
     return true;
 }
 
@@ -188,54 +779,120 @@ bool BinParser::parse(bool &wasDataRead, Command &cmd) {
 /***********************/
 void AsciiParser::setFilename(std::string filename) {
     this->filename = filename;
+    open_trace();
+}
 
+void AsciiParser::parse_data(uint32_t data[16]) {
+    assert(false && "Function is not implemented yet");
+}
 
-    file = new std::ifstream(filename);
+bool AsciiParser::is_end_line(const char *line, size_t length) {
+    return length == 3 && memcmp(line, "END", 3) == 0;
+}
 
-    if (file->bad())
-        msg::error("Bad trace file");
+/* Finds the next line at cursor without its newline, returns false at the end of the trace */
+bool AsciiParser::next_line(const char *&line, size_t &length) {
+    const void *newline;
+    size_t scanned = 0;
 
-    msg::info("Using trace file: `" + filename + "'");
+    if (endMarked)
+        return false;
 
-    if (!file->is_open())
-        msg::error("Unable to open trace file `" + filename + "'.");
+    while ((newline = memchr(cursor + scanned, '\n', end - cursor - scanned)) == nullptr) {
+        scanned = end - cursor;
+        if (!fill(scanned + 1)) {
+            // The last line may not end with a newline
+            if (cursor == end)
+                return false;
+            newline = end;
+            break;
+        }
+    }
+
+    line = (const char *) cursor;
+    length = (const char *) newline - line;
+    cursor = std::min(end, (const uint8_t *) newline + 1);
+    endMarked = is_end_line(line, length);
+    return !endMarked;
 }
 
-void AsciiParser::parse_data(uint32_t data[16]) {
-    assert(false && "Function is not implemented yet");
+/* Parses a field made only of decimal digits into value, returns false for anything else (sign, spaces, overflow) */
+static bool parse_uint(const char *field, size_t length, uint64_t &value) {
+    if (length == 0 || length > 19)
+        return false;
+
+    value = 0;
+    for (size_t pos = 0; pos < length; pos++) {
+        unsigned int digit = (unsigned int) (field[pos] - '0');
+        if (digit > 9)
+            return false;
+        value = value * 10 + digit;
+    }
+    return true;
+}
+
+/* Parses a field like std::stoul, which the trace format was originally defined by */
+static uint64_t field_to_uint(const char *field, size_t length) {
+    uint64_t value;
+    if (parse_uint(field, length, value))
+        return value;
+    return std::stoul(std::string(field, length));
+}
+
+/* Commands outside of the selection are still parsed on top of the previous ones, the next ones may carry their fields */
+bool AsciiParser::parse(bool &wasDataRead, Command &cmd) {
+    const char *line;
+    size_t length;
+    while (next_line(line, length)) {
+        parse_line(line, length, wasDataRead, cmd);
+        if (selection.matches(cmd.add.channel, cmd.add.rank, cmd.add.bank))
+            return true;
+
+        skippedUntil = std::max(skippedUntil, cmd.issueTime);
+        cmd.add.reset();
+    }
+    return false;
 }
 
 /* Command format:
  * 1. <timestamp>,<command>,<bank>
  * 2. <timestamp>,<command>,<bank>,<data>
  * 3. <timestamp>,ACT,<bank>,<rank>
+ *
+ * Fields are separated by one or more commas, empty fields are ignored.
  */
-// TODO: Make parsing simpler by parsing each command independently
-bool AsciiParser::parse(bool &wasDataRead, Command &cmd) {
-    std::string line;
-    bool result = false;
-    if (std::getline(*file, line)) {
-        result = true;
-    } else {
-        return false;
-    }
-
-    auto tokens = splitStrAt(line, DELIM);
+void AsciiParser::parse_line(const char *line, size_t length, bool &wasDataRead, Command &cmd) const {
+    const char *lineEnd = line + length;
+    const char *field = line;
     uint64_t count = 0;
+    size_t fieldCount = 0;
     wasDataRead = false;
-    for (auto token : tokens) {
+
+    while (field < lineEnd) {
+        const char *fieldEnd = (const char *) memchr(field, DELIM[0], lineEnd - field);
+        if (fieldEnd == nullptr)
+            fieldEnd = lineEnd;
+        size_t fieldLength = fieldEnd - field;
+        const char *token = field;
+        field = fieldEnd + 1;
+        if (fieldLength == 0)
+            continue;
+        fieldCount++;
+
         switch (count++) {
-            case (0): // 1st token: Command time
-                cmd.issueTime = std::stoul(line);
+            case (0): { // 1st token: Command time, parsed from the start of the line
+                uint64_t issueTime;
+                if (token == line && parse_uint(token, fieldLength, issueTime))
+                    cmd.issueTime = issueTime;
+                else
+                    cmd.issueTime = std::stoul(std::string(line, length));
                 break;
+            }
             case (1): { // 2nd token: CommandType
-                int cmdIter = 0;
                 // Iterate over all possible command types to find a match
-                for (auto i = static_cast<CommandType>(cmdIter); cmdIter < int(CommandType::MAX); cmdIter++) {
-                    // Is this a match?
-                    if (commandString[static_cast<int>(static_cast<CommandType>(cmdIter))]
-                                .compare(token) == 0) {
-                        // Yes, set the command type
+                for (int cmdIter = 0; cmdIter < int(CommandType::MAX); cmdIter++) {
+                    const std::string &name = commandString[cmdIter];
+                    if (name.length() == fieldLength && memcmp(name.data(), token, fieldLength) == 0) {
                         cmd.type = static_cast<CommandType>(cmdIter);
                         break;
                     }
@@ -243,25 +900,24 @@ bool AsciiParser::parse(bool &wasDataRead, Command &cmd) {
                 break;
             }
             case (2): {
-                cmd.add.bank = std::stoul(token);
+                cmd.add.bank = field_to_uint(token, fieldLength);
                 break;
             }
-            case (3):{
+            case (3): {
                 bool isRdCmd = cmd.type == CommandType::RD || cmd.type == CommandType::RDA;
                 bool isWrCmd = cmd.type == CommandType::WR || cmd.type == CommandType::WRA;
                 bool isIoCmd = isRdCmd || isWrCmd;
                 if (isIoCmd) {
-                    cmd.add.col = static_cast<uint64_t>(std::stoul(token));
+                    cmd.add.col = field_to_uint(token, fieldLength);
                 } else if (cmd.type == CommandType::ACT) {
-                    cmd.add.row = std::stoul(token);
+                    cmd.add.row = field_to_uint(token, fieldLength);
                     count = (uint64_t)-1;
                 } else {
-                    msg::error("Trace element: `" + line + "' contains illegal token(s)");
+                    msg::error("Trace element: `" + std::string(line, length) + "' contains illegal token(s)");
                 }
                 break;
             }
             case (4): {
-                // TODO fix this:
                 bool isRdCmd = cmd.type == CommandType::RD || cmd.type == CommandType::RDA;
                 bool isWrCmd = cmd.type == CommandType::WR || cmd.type == CommandType::WRA;
                 bool isIoCmd = isRdCmd || isWrCmd;
@@ -272,45 +928,229 @@ bool AsciiParser::parse(bool &wasDataRead, Command &cmd) {
                 bool readData = isIoCmd && isTraceRdWR
                                 || isWrCmd && isTraceWr;
 
-                if (readData){
+                if (readData) {
                     // Reads data in hexadecimal without the '0x' or any other suffix
-                    // Error if data string is not of length
-                    //   burstLength*sizeof(unsigned int)*(number of hex bits in a byte)
-                    msg::error(token.length() != 8 * sizeof(unsigned long) * 2,
-                               "Data size for command at time `" + std::to_string(cmd.issueTime) +
-                               "' is not of length " + std::to_string(8 * sizeof(unsigned long) * 2));
-
-                    // Extract the data from the string in chunks of 32 bits
-                    for (int dataElementCount = 0; dataElementCount < 16; dataElementCount++) {
-                        unsigned int dataElementLengthInHex = sizeof(uint32_t) * 2;
-                        auto substring = "0x" + token.substr(dataElementLengthInHex * dataElementCount, dataElementLengthInHex);
-                        cmd.data[dataElementCount] = static_cast<uint32_t>(std::stoul(substring, nullptr, 16));
-                    }
+                    if (fieldLength != DATA_DIGITS)
+                        msg::error("Data size for command at time `" + std::to_string(cmd.issueTime) +
+                                   "' is not of length " + std::to_string(DATA_DIGITS));
+                    if (!decodeHexLine(token, cmd.data))
+                        msg::error("Data for command at time `" + std::to_string(cmd.issueTime) +
+                                   "' is not hexadecimal");
                     wasDataRead = true;
                 } else {
-                    msg::error("Trace element: `" + line + "' contains illegal token(s)");
+                    msg::error("Trace element: `" + std::string(line, length) + "' contains illegal token(s)");
                 }
                 break;
             }
             default: {
-                msg::error("Illegal command trace format, error at `" + line + "'. Please read help.");
+                msg::error("Illegal command trace format, error at `" + std::string(line, length) + "'. Please read help.");
             }
         }
     }
 
-    msg::error(cmd.type == CommandType::PRE &&  tokens.size() != 3,
-               "PRE command at time: " + std::to_string(cmd.issueTime) + " doesn't have enough parameters.");
-    msg::error((cmd.type == CommandType::RD || cmd.type == CommandType::RDA || cmd.type == CommandType::WR || cmd.type == CommandType::WRA) &&  tokens.size() < 4,
-               "I/O command at time: " + std::to_string(cmd.issueTime) + " doesn't have enough parameters.");
-    msg::error(cmd.type == CommandType::ACT &&  tokens.size() != 4,
-               "ACT command at time: " + std::to_string(cmd.issueTime) + " doesn't have enough parameters.");
+    if (cmd.type == CommandType::PRE && fieldCount != 3)
+        msg::error("PRE command at time: " + std::to_string(cmd.issueTime) + " doesn't have enough parameters.");
+    if ((cmd.type == CommandType::RD || cmd.type == CommandType::RDA || cmd.type == CommandType::WR || cmd.type == CommandType::WRA) && fieldCount < 4)
+        msg::error("I/O command at time: " + std::to_string(cmd.issueTime) + " doesn't have enough parameters.");
+    if (cmd.type == CommandType::ACT && fieldCount != 4)
+        msg::error("ACT command at time: " + std::to_string(cmd.issueTime) + " doesn't have enough parameters.");
 
     verify_cmd(cmd.add, cmd.type);
 
-    dbgstream << line << std::endl;
-    dbgstream << "result:: " << result << std::endl;
+    dbgstream << std::string(line, length) << std::endl;
+}
+
+/*******************************/
+/* Class : ParallelAsciiParser */
+/*******************************/
+ParallelAsciiParser::ParallelAsciiParser(size_t threads, size_t chunkSize)
+        : threads(threads), chunkSize(chunkSize), ring(2 * threads) {}
+
+ParallelAsciiParser::~ParallelAsciiParser() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stop = true;
+    }
+    chunkFilled.notify_all();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+/* Takes the next lines of the trace, up to the end of the line crossing chunkSize, returns false at the end of the
+ * trace */
+bool ParallelAsciiParser::fill_chunk(Chunk &chunk) {
+    // Only wait for input while none is buffered, so that the commands streamed through a pipe are not held back until
+    // a whole chunk arrived
+    if (endMarked || !fill(1))
+        return false;
+
+    size_t length = std::min(chunkSize, (size_t) (end - cursor));
+    const void *newline;
+    while ((newline = memchr(cursor + length - 1, '\n', end - cursor - length + 1)) == nullptr) {
+        if (!fill(end - cursor + 1)) {
+            // The last line may not end with a newline
+            newline = end - 1;
+            break;
+        }
+    }
+    length = (const uint8_t *) newline + 1 - cursor;
+
+    // The chunk ends before the end-of-input marker, if it holds it, and nothing is read after it
+    for (const char *line = (const char *) cursor; line < (const char *) cursor + length;) {
+        const char *lineEnd = (const char *) memchr(line, '\n', (const char *) cursor + length - line);
+        lineEnd = (lineEnd == nullptr) ? (const char *) cursor + length : lineEnd;
+        if (is_end_line(line, lineEnd - line)) {
+            length = line - (const char *) cursor;
+            endMarked = true;
+            break;
+        }
+        line = (const char *) memmem(line, (const char *) cursor + length - line, "\nEND", 4);
+        line = (line == nullptr) ? (const char *) cursor + length : line + 1;
+    }
+    if (length == 0)
+        return false;
+
+    if (mapping != nullptr) {
+        chunk.begin = (const char *) cursor;
+    } else {
+        chunk.text.assign(cursor, cursor + length);
+        chunk.begin = chunk.text.data();
+    }
+    chunk.end = chunk.begin + length;
+    cursor += length;
+    return true;
+}
+
+void ParallelAsciiParser::parse_chunk(Chunk &chunk) const {
+    Command blank;
+    blank.type = CommandType::MAX;  // Unknown commands keep the type of the previous chunk, see carry_over()
+    memset(blank.data, 0, sizeof(blank.data));
+    bool typeSet = false, dataSet = false;
+    bool dropped = false;           // The command at chunk.size was dropped, the next line is parsed on top of it
+
+    chunk.size = 0;
+    chunk.typeCarried = chunk.dataCarried = 0;
+    chunk.skippedUntil = 0;
+    for (const char *line = chunk.begin; line < chunk.end;) {
+        const char *newline = (const char *) memchr(line, '\n', chunk.end - line);
+        const char *lineEnd = (newline == nullptr) ? chunk.end : newline;
+
+        if (chunk.size == chunk.cmds.size())
+            chunk.cmds.resize(std::max<size_t>(1024, 2 * chunk.cmds.size()));
+        Command &cmd = chunk.cmds[chunk.size];
+        if (!dropped)
+            cmd = (chunk.size > 0) ? chunk.cmds[chunk.size - 1] : blank;
+        cmd.add.reset();
+
+        bool wasDataRead;
+        parse_line(line, lineEnd - line, wasDataRead, cmd);
+        cmd.hasData = wasDataRead;
+        typeSet = typeSet || cmd.type != CommandType::MAX;
+        dataSet = dataSet || wasDataRead;
+        line = lineEnd + 1;
+
+        dropped = !selection.matches(cmd.add.channel, cmd.add.rank, cmd.add.bank);
+        if (dropped) {
+            chunk.skippedUntil = std::max(chunk.skippedUntil, cmd.issueTime);
+            continue;
+        }
+        chunk.typeCarried += !typeSet;
+        chunk.dataCarried += !dataSet;
+        chunk.size++;
+    }
+
+    chunk.last = dropped ? chunk.cmds[chunk.size] : chunk.cmds[chunk.size - 1];
+    chunk.lastTypeCarried = !typeSet;
+    chunk.lastDataCarried = !dataSet;
+}
+
+/* Gives the first commands of a chunk the fields they would have inherited from the previous command of the trace */
+void ParallelAsciiParser::carry_over(Chunk &chunk) const {
+    for (size_t pos = 0; pos < chunk.typeCarried; pos++) {
+        chunk.cmds[pos].type = lastParsed.type;
+    }
+    for (size_t pos = 0; pos < chunk.dataCarried; pos++) {
+        memcpy(chunk.cmds[pos].data, lastParsed.data, sizeof(lastParsed.data));
+    }
+
+    if (chunk.lastTypeCarried)
+        chunk.last.type = lastParsed.type;
+    if (chunk.lastDataCarried)
+        memcpy(chunk.last.data, lastParsed.data, sizeof(lastParsed.data));
+}
+
+/* Body of the worker threads, parses the chunks in the order they are filled */
+void ParallelAsciiParser::work_loop() {
+    std::unique_lock<std::mutex> guard(lock);
+
+    while (true) {
+        chunkFilled.wait(guard, [this] {return stop || claimed < filled;});
+        if (stop)
+            return;
+
+        Chunk &chunk = ring[claimed++ % ring.size()];
+        guard.unlock();
+        parse_chunk(chunk);
+        guard.lock();
 
-    return result;
+        chunk.parsed = true;
+        chunkParsed.notify_all();
+    }
 }
 
+size_t ParallelAsciiParser::parse_batch(Command *out, size_t n) {
+    size_t copied = 0;
+
+    // Workers start on the first batch, once the trace type is known
+    if (workers.empty()) {
+        for (size_t worker = 0; worker < threads; worker++) {
+            workers.emplace_back(&ParallelAsciiParser::work_loop, this);
+        }
+    }
+
+    while (copied < n) {
+        // Keep every chunk of the ring in flight, drained chunks are not used by any worker
+        while (!inputEnded && filled - drained < ring.size()) {
+            if (!fill_chunk(ring[filled % ring.size()])) {
+                inputEnded = true;
+                break;
+            }
+            std::lock_guard<std::mutex> guard(lock);
+            filled++;
+            chunkFilled.notify_one();
+        }
+        if (drained == filled)
+            break; // End of the trace
+
+        Chunk &chunk = ring[drained % ring.size()];
+        if (chunkPos == 0) {
+            std::unique_lock<std::mutex> guard(lock);
+            chunkParsed.wait(guard, [&chunk] {return chunk.parsed;});
+            guard.unlock();
+            carry_over(chunk);
+            skippedUntil = std::max(skippedUntil, chunk.skippedUntil);
+        }
 
+        size_t count = std::min(n - copied, chunk.size - chunkPos);
+        std::copy(chunk.cmds.begin() + chunkPos, chunk.cmds.begin() + chunkPos + count, out + copied);
+        copied += count;
+        chunkPos += count;
+
+        if (chunkPos == chunk.size) {
+            lastParsed = chunk.last;
+            chunkPos = 0;
+            chunk.parsed = false;
+            drained++;
+        }
+    }
+    return copied;
+}
+
+bool ParallelAsciiParser::parse(bool &wasDataRead, Command &cmd) {
+    if (parse_batch(&cmd, 1) == 0)
+        return false;
+
+    wasDataRead = cmd.hasData;
+    return true;
+}
@@ -14,56 +14,334 @@ Released under the MIT License
 #define VAMPIRE_PARSER_H
 
 
+#include <atomic>
+#include <condition_variable>
 #include <cstdio>
+#include <cstdint>
 #include <functional>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 #include "consts.h"
 #include "address.h"
 #include "command.h"
+#include "selection.h"
+#include "traceFormat.h"
+#include "traceStream.h"
 
 
 class Parser {
 private:
 protected:
+    static const size_t BUFFER_SIZE = 1 << 20;          // Read size for inputs that are not mapped
+    static const unsigned int FOLLOW_POLL_INTERVAL = 10;    // ms between reads of a followed trace that did not grow
+
     std::string DELIM;
     std::string filename = "";
-    std::ifstream *file;
+    int fd = -1;                    // Descriptor of the trace file
+    TraceStream *stream = nullptr;  // Contents of the trace after decompression, nullptr if fd is read directly
     TraceType traceType;
     uint64_t bytes_read;
+    Command lastParsed;     // Last command returned by parse_batch(), the next batch is parsed on top of it
+
+    /* Window over the trace contents: a read-only mapping of plain regular files, a buffer refilled by fill() for
+     * anything else (pipes, compressed traces) */
+    uint8_t *mapping = nullptr;
+    size_t mappingSize = 0;
+    std::vector<uint8_t> buffer;
+    const uint8_t *cursor = nullptr;                    // Next byte to decode
+    const uint8_t *end = nullptr;                       // End of the bytes available in the mapping or the buffer
+    uint64_t consumed = 0;                              // # of bytes before the buffer, for error messages
+
+    bool directIO = false;              // Reads regular files with DirectStream instead of mapping them
+    bool follow = false;                // Waits for a trace that reached its end to grow, see setFollow()
+    unsigned int followTimeout = 0;     // ms without growth after which a followed trace ends, 0 waits forever
+    unsigned int followIdle = 0;
+    bool endMarked = false;             // The end-of-input marker of the trace was read, nothing after it is parsed
+
+    Selection selection;                // Commands outside of it are dropped right after their address is decoded
+    uint64_t skippedUntil = 0;          // Latest issue time of the dropped commands
+
+    /* Opens the trace file and sets up the window over its contents, exits on failure */
+    void open_trace();
+    /* Sets up stream to read the trace from source, decompressing and extracting it if needed */
+    void open_stream(TraceStream *source);
+    /* Makes sure that at least `bytes' bytes are available at cursor, returns false if the input ends before that */
+    bool fill(size_t bytes);
 public:
     Parser();
-    ~Parser();
+    virtual ~Parser();
     virtual void setFilename(std::string filename) = 0;
     virtual std::string getFilename();
+    /* Keeps reading a trace that is still being written: at its end the parser waits for more commands until the
+     * end-of-input marker is read or nothing is written for timeout ms (0 waits forever). Set before setFilename() */
+    void setFollow(bool follow, unsigned int timeout);
+    /* Reads a regular trace file in large blocks that bypass the page cache (see DirectStream) instead of mapping it,
+     * for traces larger than the page cache. Set before setFilename() */
+    void setDirectIO(bool directIO);
 
     TraceType getTraceType() const;
-    void setTraceType(TraceType traceType);
+    virtual void setTraceType(TraceType traceType);
+    /* Only hands out the commands in the address ranges of selection, set before the first command is parsed */
+    void setSelection(const Selection &selection);
+    /* Latest issue time of the commands dropped so far by the selection, 0 if none was dropped */
+    uint64_t getSkippedUntil() const;
 
     bool verifyCmd(MappedAdd &add, CommandType &cmdType);
 
     virtual void parse_data(uint32_t data[16]) = 0;
     virtual bool parse(bool &wasDataRead, Command &cmd) = 0;
+    /* Parses up to n commands into out, returns # of commands parsed, 0 at the end of the trace.
+     * The commands are parsed exactly as a sequence of calls to parse() on the same Command would */
+    virtual size_t parse_batch(Command *out, size_t n);
+
+    /* Byte offset in the trace of the next command to parse */
+    uint64_t position() const;
+    /* Whether the trace is mapped, only mapped traces can be indexed and seeked */
+    bool isMapped() const;
+    /* Resumes parsing at the command at byte offset, on top of the command before it. Returns false if the trace
+     * cannot be seeked */
+    virtual bool seek(uint64_t offset, const Command &previous);
     static std::vector<std::string> splitStrAt(const std::string& str, const std::string& delim);
 
     bool verify_request(MappedAdd &add, CommandType &cmdType);
 };
 
+/*
+ * Decodes binary traces straight from the window over the trace, without intermediate copies or per-command
+ * allocations. Traces starting with a TraceHeader are decoded as version 2 (see traceFormat.h), any other trace as
+ * version 1. A command of type END_TYPE (version 1) or TRACE_END_TYPE (version 2) ends the trace.
+ */
 class BinParser : public Parser {
 private:
-    int64_t fileSize = 0;
+    static const size_t HEADER_SIZE = 2 * sizeof(uint64_t);
+    static const size_t DATA_SIZE   = 16 * sizeof(uint32_t);
+    static const unsigned int END_TYPE = 0b111;         // Command type of the end-of-input marker of version 1 traces
+
+    TraceHeader header = {};
+    TraceLayout *layout = nullptr;                      // Layout of a version 2 trace, nullptr for version 1
+    uint64_t lastIssueTime = 0;
+    alignas(64) unsigned int lastData[16] = {};         // Data of the previous command of a version 2 trace
+
+    bool decode(Command &cmd);
+    bool decode_v2(Command &cmd);
 public:
+    ~BinParser();
     void setFilename(std::string filename);
+    void setTraceType(TraceType traceType) override;
     void parse_data(uint32_t data[16]) override;
     bool parse(bool &wasDataRead, Command &cmd) override;
+    size_t parse_batch(Command *out, size_t n) override;
+    bool seek(uint64_t offset, const Command &previous) override;
 };
 
+/*
+ * Runs a parser on a decoding thread which fills a bounded single-producer/single-consumer ring of command batches,
+ * while the estimation thread drains it, so that I/O and decoding overlap with the energy computation. The two
+ * threads only share the ring indices, an empty batch marks the end of the trace. A thread finding the ring empty (or
+ * full) polls it for a short while, then sleeps until the other one moves its index.
+ */
+class AsyncParser : public Parser {
+private:
+    struct Batch {
+        std::vector<Command> cmds;
+        size_t size = 0;
+        uint64_t skippedUntil = 0;          // Of the source parser once the batch was parsed
+    };
+
+    Parser *source;
+    std::vector<Batch> ring;
+    size_t batchSize;
+
+    alignas(64) std::atomic<uint64_t> head{0};     // # of batches filled, only written by the decoding thread
+    alignas(64) std::atomic<uint64_t> tail{0};     // # of batches drained, only written by the estimation thread
+    alignas(64) std::atomic<bool> stop{false};
+    std::atomic<int> sleepers{0};                  // # of threads sleeping on the ring
+    std::mutex lock;                               // Only taken to sleep on the ring or to wake a sleeper
+    std::condition_variable batchFilled, batchDrained;
+    size_t batchPos = 0;                           // Next command to hand out from the batch at tail
+    std::thread decoder;
+
+    void decode_loop();
+    /* Polls ready PARSE_SPIN times, then sleeps on moved until it holds */
+    template <typename Ready>
+    void wait_for(std::condition_variable &moved, Ready ready);
+    /* Wakes the thread sleeping on moved, if any, once an index of the ring has been stored */
+    void wake(std::condition_variable &moved);
+public:
+    /* Takes ownership of source, which must already be set up */
+    AsyncParser(Parser *source, size_t depth, size_t batchSize);
+    ~AsyncParser();
+
+    void setFilename(std::string filename);
+    void parse_data(uint32_t data[16]) override;
+    bool parse(bool &wasDataRead, Command &cmd) override;
+    size_t parse_batch(Command *out, size_t n) override;
+    bool seek(uint64_t offset, const Command &previous) override;
+};
+
+/*
+ * Splits the commands of a parser by channel (or by rank) on a demultiplexing thread, into one stream per partition
+ * that the estimator of the partition reads as its parser. Each stream is a bounded ring of batches, so that the
+ * demultiplexing thread only waits for a partition whose ring is full, and every partition has to be drained on its own
+ * thread. The commands routed to the other partitions count as dropped by the selection of a stream, the trace ends at
+ * the first command after windowEnd. Without a level (Level::MAX), every stream receives every command instead, so that
+ * several estimators share the parsing of the trace.
+ */
+class DemuxParser {
+private:
+    static const size_t DEPTH = 16;         // # of batches in the ring of each stream
+
+    struct Batch {
+        std::vector<Command> cmds;          // Empty at the end of the trace
+        uint64_t skippedUntil = 0;
+    };
+
+    class Stream : public Parser {
+    private:
+        friend class DemuxParser;
+
+        std::vector<Batch> ring;
+        std::vector<Command> filling;       // Batch being filled by the demultiplexing thread
+        uint64_t lastIssueTime = 0;         // Of the commands routed to the stream
+
+        // Protected by lock
+        std::mutex lock;
+        std::condition_variable batchFilled, batchDrained;
+        uint64_t head = 0;                  // # of batches filled
+        uint64_t tail = 0;                  // # of batches drained
+        size_t batchPos = 0;                // Next command to hand out from the batch at tail, only used by the reader
+        bool stop = false;
+    public:
+        Stream(const std::string &filename, TraceType traceType, size_t batchSize);
+
+        void setFilename(std::string filename);
+        void parse_data(uint32_t data[16]) override;
+        bool parse(bool &wasDataRead, Command &cmd) override;
+        size_t parse_batch(Command *out, size_t n) override;
+    };
+
+    Parser &source;
+    Level level;
+    uint64_t rankCount;                     // # of ranks per channel
+    uint64_t windowEnd;
+    size_t batchSize;
+    std::vector<Stream *> streams;
+    std::thread demuxer;
+
+    size_t partition_of(const MappedAdd &add) const;
+    /* Adds cmd to the batch being filled for a stream, returns false if the parser is being destroyed */
+    bool route(size_t partition, const Command &cmd);
+    /* Hands the batch being filled for a stream over to its reader, returns false if the parser is being destroyed */
+    bool publish(size_t partition);
+    void demux_loop();
+public:
+    /* Splits the commands of source, which must already be set up, at level (CHANNEL or RANK) of structCount */
+    DemuxParser(Parser &source, Level level, const uint64_t (&structCount)[int(Level::MAX)], uint64_t windowEnd,
+                size_t batchSize);
+    /* Hands every command of source, which must already be set up, to each of copies streams */
+    DemuxParser(Parser &source, size_t copies, uint64_t windowEnd, size_t batchSize);
+    ~DemuxParser();
+
+    size_t partitionCount() const {return streams.size();}
+    /* Commands of a partition, owned by the DemuxParser */
+    Parser *partition(size_t partition) {return streams[partition];}
+};
+
+/*
+ * Hands out the next `count' commands of a parser, for estimating a segment of the trace that ends where the next
+ * segment starts
+ */
+class SegmentParser : public Parser {
+private:
+    Parser *source;
+    uint64_t remaining;
+public:
+    /* Takes ownership of source, which must already be set up and positioned at the start of the segment */
+    SegmentParser(Parser *source, uint64_t count);
+    ~SegmentParser();
+
+    void setFilename(std::string filename);
+    void parse_data(uint32_t data[16]) override;
+    bool parse(bool &wasDataRead, Command &cmd) override;
+    size_t parse_batch(Command *out, size_t n) override;
+};
+
+/*
+ * Parses ASCII traces in place in the window over the trace: fields are delimited without copying the line, integers
+ * are parsed without allocation and data is decoded by decodeHexLine(). Only malformed lines fall back to std::stoul
+ * so that they are handled exactly as before. A line made only of `END' ends the trace.
+ */
 class AsciiParser : public Parser {
 private:
+    static const size_t DATA_DIGITS = 8 * sizeof(unsigned long) * 2;
+protected:
+    /* Finds the next line at cursor without its newline, returns false at the end of the trace */
+    bool next_line(const char *&line, size_t &length);
+    /* Whether a line without its newline is the end-of-input marker */
+    static bool is_end_line(const char *line, size_t length);
+    /* Parses a line without its newline on top of cmd, which holds the previous command. Only reads the parser */
+    void parse_line(const char *line, size_t length, bool &wasDataRead, Command &cmd) const;
 public:
     void setFilename(std::string filename);
     void parse_data(uint32_t data[16]) override;
     bool parse(bool &wasDataRead, Command &cmd) override;
 };
 
+/*
+ * Splits an ASCII trace into newline aligned chunks that worker threads parse into blocks of commands, the blocks are
+ * handed out in the order of the trace. Lines only depend on the previous ones through the fields they do not set
+ * (the data of a command without data, the type of an unknown command), so each chunk is parsed from a blank command
+ * and these fields are carried into its first commands when it is handed out.
+ */
+class ParallelAsciiParser : public AsciiParser {
+private:
+    struct Chunk {
+        const char *begin = nullptr;
+        const char *end = nullptr;
+        std::vector<char> text;             // Copy of the lines of the chunk when the trace is not mapped
+        std::vector<Command> cmds;
+        size_t size = 0;                    // # of commands parsed in cmds
+        bool parsed = false;
+
+        // The commands of the chunk dropped by the selection are not in cmds but the commands after them may carry
+        // their fields, so the fields carried from the previous chunk are tracked over all the lines
+        Command last;                       // Last command of the chunk, dropped or not
+        size_t typeCarried = 0;             // # of commands in cmds that carry the type of the previous chunk
+        size_t dataCarried = 0;             // # of commands in cmds that carry the data of the previous chunk
+        bool lastTypeCarried = false;
+        bool lastDataCarried = false;
+        uint64_t skippedUntil = 0;
+    };
+
+    size_t threads;
+    size_t chunkSize;
+    std::vector<Chunk> ring;
+    std::vector<std::thread> workers;
+
+    // Protected by lock: chunks are filled by the estimation thread, parsed by the workers in any order and drained in
+    // the order they were filled
+    std::mutex lock;
+    std::condition_variable chunkFilled, chunkParsed;
+    uint64_t filled = 0;                    // # of chunks filled
+    uint64_t claimed = 0;                   // # of chunks claimed by a worker
+    bool stop = false;
+
+    uint64_t drained = 0;                   // # of chunks handed out, only used by the estimation thread
+    size_t chunkPos = 0;                    // Next command to hand out from the chunk being drained
+    bool inputEnded = false;
+
+    bool fill_chunk(Chunk &chunk);
+    void parse_chunk(Chunk &chunk) const;
+    void carry_over(Chunk &chunk) const;
+    void work_loop();
+public:
+    ParallelAsciiParser(size_t threads, size_t chunkSize);
+    ~ParallelAsciiParser();
+
+    bool parse(bool &wasDataRead, Command &cmd) override;
+    size_t parse_batch(Command *out, size_t n) override;
+};
+
 #endif //VAMPIRE_PARSER_H
@@ -0,0 +1,65 @@
+/*
+
+SELECTION.CPP
+
+VAMPIRE: Variation-Aware model of Memory Power Informed by Real Experiments
+https://github.com/CMU-SAFARI/VAMPIRE
+
+Copyright (c) SAFARI Research Group at Carnegie Mellon University and ETH Zürich
+Released under the MIT License
+
+*/
+
+#include "helper.h"
+#include "selection.h"
+
+/* Parses a decimal number making up the whole string, exits otherwise */
+static uint64_t to_uint(const std::string &str, const std::string &spec) {
+    char *strEnd = nullptr;
+    uint64_t value = strtoull(str.c_str(), &strEnd, 10);
+    msg::error(str.empty() || !isdigit((unsigned char) str[0]) || *strEnd != '\0',
+               "Option '-select': malformed selection `" + spec + "', see vampire --help for more details.");
+    return value;
+}
+
+Selection Selection::parse(const std::string &spec) {
+    Selection selection;
+
+    for (auto &term : Helper::splitStr(spec, ',')) {
+        size_t equals = term.find('=');
+        msg::error(equals == std::string::npos,
+                   "Option '-select': malformed selection `" + spec + "', see vampire --help for more details.");
+        std::string key = term.substr(0, equals), value = term.substr(equals + 1);
+
+        if (key == "time") {
+            size_t colon = value.find(':');
+            msg::error(colon == std::string::npos,
+                       "Option '-select': time range `" + value + "' is not of the form <start>:<end>.");
+            if (colon > 0)
+                selection.time.first = to_uint(value.substr(0, colon), spec);
+            if (colon + 1 < value.length())
+                selection.time.last = to_uint(value.substr(colon + 1), spec);
+            msg::error(selection.time.first > selection.time.last,
+                       "Option '-select': time range `" + value + "' starts after it ends.");
+            continue;
+        }
+
+        Level level = Level::MAX;
+        if (key == "chan" || key == "channel")
+            level = Level::CHANNEL;
+        else if (key == "rank")
+            level = Level::RANK;
+        else if (key == "bank")
+            level = Level::BANK;
+        else
+            msg::error("Option '-select': unknown key `" + key + "', expected chan, rank, bank or time.");
+
+        Range &range = selection.ranges[int(level)];
+        size_t dash = value.find('-');
+        range.first = to_uint(value.substr(0, dash), spec);
+        range.last = (dash == std::string::npos) ? range.first : to_uint(value.substr(dash + 1), spec);
+        msg::error(range.first > range.last, "Option '-select': " + key + " range `" + value + "' is empty.");
+        selection.isAddressSelected = true;
+    }
+    return selection;
+}
@@ -0,0 +1,63 @@
+/*
+
+SELECTION.H
+
+VAMPIRE: Variation-Aware model of Memory Power Informed by Real Experiments
+https://github.com/CMU-SAFARI/VAMPIRE
+
+Copyright (c) SAFARI Research Group at Carnegie Mellon University and ETH Zürich
+Released under the MIT License
+
+*/
+
+#ifndef VAMPIRE_SELECTION_H
+#define VAMPIRE_SELECTION_H
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+
+#include "consts.h"
+
+/*
+ * Subset of the commands of a trace to estimate (-select). The parsers evaluate the address ranges right after decoding
+ * the address of a command and drop the commands outside of them before their data is copied. The time range is
+ * applied as the -from/-to window, so that the state of the selected banks is still warmed up before it.
+ */
+class Selection {
+private:
+    struct Range {
+        uint64_t first = 0;
+        uint64_t last = UINT64_MAX;
+
+        bool contains(uint64_t value) const {return value >= first && value <= last;}
+    };
+
+    Range ranges[int(Level::BANK) + 1];     // Channel, rank and bank
+    bool isAddressSelected = false;
+public:
+    Range time;
+
+    /* Parses <key>=<value>[,<key>=<value>...] with the keys chan, rank and bank taking <n> or <first>-<last>, and time
+     * taking <start>:<end> where either may be left out. Exits on malformed selections */
+    static Selection parse(const std::string &spec);
+
+    /* Whether commands are dropped by their address */
+    bool isSelective() const {return isAddressSelected;}
+    bool matches(uint64_t channel, uint64_t rank, uint64_t bank) const {
+        return ranges[int(Level::CHANNEL)].contains(channel) && ranges[int(Level::RANK)].contains(rank)
+               && ranges[int(Level::BANK)].contains(bank);
+    }
+    /* Keeps only the value of level (CHANNEL, RANK or BANK) in its selected range, which may leave it empty */
+    void narrow(Level level, uint64_t value) {
+        Range &range = ranges[int(level)];
+        range.first = std::max(range.first, value);
+        range.last = std::min(range.last, value);
+    }
+    /* Whether some banks of the rank are selected */
+    bool matchesRank(uint64_t channel, uint64_t rank) const {
+        return ranges[int(Level::CHANNEL)].contains(channel) && ranges[int(Level::RANK)].contains(rank);
+    }
+};
+
+#endif //VAMPIRE_SELECTION_H
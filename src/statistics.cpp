@@ -280,3 +280,23 @@ void Statistics::calculateTotal(DramSpec &dramSpec, uint64_t endTime) {
     this->avgPower->setValue(totalEnergy->getValue()/(2.5*this->totalCycleCount->getValue()));
     this->avgCurrent->setValue(this->avgPower->getValue()/dramSpec.vdd);
 }
+
+void Statistics::merge(const Statistics &other) {
+    for (uint64_t cmdType = 0; cmdType < cmdCount->size(); cmdType++) {
+        (*cmdCount)[cmdType] += (*other.cmdCount)[cmdType];
+        (*cmdCycles)[cmdType] += (*other.cmdCycles)[cmdType];
+    }
+
+    *totalActStandbyCycles += other.totalActStandbyCycles->getValue();
+    *totalPreStandbyCycles += other.totalPreStandbyCycles->getValue();
+
+    *totalReadEnergy += other.totalReadEnergy->getValue();
+    *totalWriteEnergy += other.totalWriteEnergy->getValue();
+    *totalActCmdEnergy += other.totalActCmdEnergy->getValue();
+    *totalPreCmdEnergy += other.totalPreCmdEnergy->getValue();
+    *totalActiveStandbyEnergy += other.totalActiveStandbyEnergy->getValue();
+    *totalPrechargeStandbyEnergy += other.totalPrechargeStandbyEnergy->getValue();
+
+    // The parts run side by side, the trace lasts as long as the longest of them
+    totalCycleCount->setValue(std::max(totalCycleCount->getValue(), other.totalCycleCount->getValue()));
+}
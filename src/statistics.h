@@ -95,6 +95,8 @@ public:
     ~VectorStat();
 
     T &operator[](uint64_t index) {return members->operator[](index);};
+    const T &operator[](uint64_t index) const {return members->operator[](index);};
+    uint64_t size() const {return members->size();};
 
     std::string toString() const {
         std::stringstream ss;
@@ -177,6 +179,9 @@ public:
     void print_stats() const;
     void write_csv(std::string *csvFilename) const;
     void calculateTotal(DramSpec &dramSpec, uint64_t endTime);
+    /* Adds the commands, cycles and energy of the statistics of another part of the trace, estimated separately. The
+     * totals are calculated again afterwards */
+    void merge(const Statistics &other);
 };
 
 #endif //VAMPIRE_STATISTICS_H
@@ -0,0 +1,159 @@
+/*
+
+TRACEFORMAT.CPP
+
+VAMPIRE: Variation-Aware model of Memory Power Informed by Real Experiments
+https://github.com/CMU-SAFARI/VAMPIRE
+
+Copyright (c) SAFARI Research Group at Carnegie Mellon University and ETH Zürich
+Released under the MIT License
+
+*/
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "traceFormat.h"
+
+/***********************/
+/* Class : TraceLayout */
+/***********************/
+TraceLayout::TraceLayout(const TraceHeader &header) {
+    msg::error(memcmp(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0, "Trace does not have a version 2 header.");
+    msg::error(header.version != TRACE_VERSION, "Unsupported binary trace version: " + std::to_string(header.version));
+    msg::error(header.headerSize < sizeof(TraceHeader), "Binary trace header is truncated.");
+
+    // Fields are packed from the column up to the channel
+    unsigned int bits = 0;
+    for (int level = int(Level::MAX) - 1; level >= 0; level--) {
+        msg::error(header.fieldBits[level] > 32, "Binary trace has an address field wider than 32 bits.");
+        shift[level] = bits;
+        mask[level] = (1ull << header.fieldBits[level]) - 1;
+        bits += header.fieldBits[level];
+    }
+    typeShift = bits;
+    bits += TRACE_TYPE_BITS + TRACE_FLAG_BITS;
+
+    msg::error(bits > 64, "Binary trace has address fields wider than 59 bits in total.");
+    packedBytes = (bits + 7) / 8;
+}
+
+/***********************/
+/* Class : TraceWriter */
+/***********************/
+TraceHeader TraceWriter::make_header(const uint64_t structCount[int(Level::MAX)], TraceType traceType) {
+    TraceHeader header = {};
+
+    memcpy(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    header.version = TRACE_VERSION;
+    header.headerSize = sizeof(TraceHeader);
+    header.traceType = (uint8_t) traceType;
+    for (int level = 0; level < int(Level::MAX); level++) {
+        header.structCount[level] = structCount[level];
+        while (header.fieldBits[level] < 64 && (1ull << header.fieldBits[level]) < structCount[level]) {
+            header.fieldBits[level]++;
+        }
+    }
+    return header;
+}
+
+TraceWriter::TraceWriter(const std::string &filename, const uint64_t structCount[int(Level::MAX)], TraceType traceType)
+        : filename(filename), header(make_header(structCount, traceType)), layout(header) {
+    fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    msg::error(fd < 0, "Unable to open output trace `" + filename + "'.");
+
+    buffer.reserve(BUFFER_SIZE + TRACE_MAX_VARINT_SIZE + sizeof(uint64_t) + TRACE_DATA_SIZE);
+    buffer.insert(buffer.end(), (const uint8_t *) &header, (const uint8_t *) &header + sizeof(header));
+}
+
+TraceWriter::~TraceWriter() {
+    close();
+    delete index;
+}
+
+void TraceWriter::setIndex(TraceIndexBuilder *index) {
+    delete this->index;
+    this->index = index;
+}
+
+void TraceWriter::flush() {
+    size_t written = 0;
+    while (written < buffer.size()) {
+        ssize_t bytes = ::write(fd, buffer.data() + written, buffer.size() - written);
+        if (bytes < 0 && errno == EINTR)
+            continue;
+        msg::error(bytes <= 0, "Unable to write output trace `" + filename + "'.");
+        written += bytes;
+    }
+    this->written += written;
+    buffer.clear();
+}
+
+void TraceWriter::write(const Command *cmds, size_t n) {
+    for (size_t pos = 0; pos < n; pos++) {
+        const Command &cmd = cmds[pos];
+        if (index != nullptr)
+            index->add(cmd, written + buffer.size());
+
+        const unsigned long fields[int(Level::MAX)] = {cmd.add.channel, cmd.add.rank, cmd.add.bank, cmd.add.row,
+                                                       cmd.add.col};
+
+        // Timestamp delta
+        uint64_t delta = zigzag_encode((int64_t) (cmd.issueTime - lastIssueTime));
+        lastIssueTime = cmd.issueTime;
+        while (delta >= 0x80) {
+            buffer.push_back((uint8_t) (delta | 0x80));
+            delta >>= 7;
+        }
+        buffer.push_back((uint8_t) delta);
+
+        // Packed fields
+        uint64_t packed = 0;
+        for (int level = 0; level < int(Level::MAX); level++) {
+            if (fields[level] > layout.mask[level])
+                msg::error("Command at time " + std::to_string(cmd.issueTime) + " does not fit in the geometry of "
+                           "output trace `" + filename + "'.");
+            packed |= (uint64_t) fields[level] << layout.shift[level];
+        }
+        TraceData source = TraceData::PAYLOAD;
+        if (memcmp(cmd.data, lastData, TRACE_DATA_SIZE) == 0)
+            source = TraceData::PREVIOUS;
+        else if (noSetBits(cmd.data) == 0)
+            source = TraceData::ZERO;
+
+        packed |= (uint64_t) cmd.type << layout.typeShift;
+        packed |= (uint64_t) cmd.hasData << (layout.typeShift + TRACE_TYPE_BITS);
+        packed |= (uint64_t) source << (layout.typeShift + TRACE_TYPE_BITS + 1);
+        for (size_t byte = 0; byte < layout.packedBytes; byte++) {
+            buffer.push_back((uint8_t) (packed >> (8 * byte)));
+        }
+
+        if (source == TraceData::PAYLOAD)
+            buffer.insert(buffer.end(), (const uint8_t *) cmd.data, (const uint8_t *) cmd.data + TRACE_DATA_SIZE);
+        memcpy(lastData, cmd.data, TRACE_DATA_SIZE);
+
+        header.commandCount++;
+        if (buffer.size() >= BUFFER_SIZE)
+            flush();
+    }
+}
+
+void TraceWriter::close() {
+    if (fd < 0)
+        return;
+    flush();
+
+    // Outputs that cannot seek (e.g., pipes) keep a command count of 0
+    if (lseek(fd, offsetof(TraceHeader, commandCount), SEEK_SET) >= 0) {
+        msg::error(pwrite(fd, &header.commandCount, sizeof(header.commandCount), offsetof(TraceHeader, commandCount))
+                   != sizeof(header.commandCount), "Unable to write output trace `" + filename + "'.");
+    }
+    ::close(fd);
+    fd = -1;
+
+    if (index != nullptr && !index->save(filename))
+        msg::warning("Output trace `" + filename + "' is not a regular file, it was not indexed.");
+}
@@ -0,0 +1,108 @@
+/*
+
+TRACEFORMAT.H
+
+VAMPIRE: Variation-Aware model of Memory Power Informed by Real Experiments
+https://github.com/CMU-SAFARI/VAMPIRE
+
+Copyright (c) SAFARI Research Group at Carnegie Mellon University and ETH Zürich
+Released under the MIT License
+
+*/
+
+#ifndef VAMPIRE_TRACEFORMAT_H
+#define VAMPIRE_TRACEFORMAT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "consts.h"
+#include "command.h"
+#include "traceIndex.h"
+
+/*
+ * Header of version 2 binary traces, which describe themselves instead of relying on the fixed layout of version 1.
+ * The header is followed by the commands, each one being:
+ *
+ *   <timestamp delta (zigzag LEB128 varint)><packed fields (packedBytes)>[<64-byte data>]
+ *
+ * The packed fields hold, from the least significant bit, the column, row, bank, rank and channel with the widths of
+ * the header, then the command type (TRACE_TYPE_BITS), whether the data was read from the trace for the model (1 bit)
+ * and where the data of the command comes from (TraceData, 2 bits). They are stored little-endian in the fewest bytes
+ * that fit them, as are all fields of the header.
+ *
+ * The data of every command is kept, not only the data of the commands with data, as the energy of some commands
+ * depends on the data left over by the previous ones (e.g., a RD in an ASCII trace keeps the data of the previous WR).
+ *
+ * A command of type TRACE_END_TYPE marks the end of the trace, so that a writer can end a trace it streams to VAMPIRE
+ * without closing it. Anything after the marker is ignored.
+ */
+struct TraceHeader {
+    char magic[8];                              // TRACE_MAGIC
+    uint32_t version;                           // TRACE_VERSION
+    uint32_t headerSize;                        // Bytes before the first command
+    uint64_t commandCount;                      // # of commands, 0 if unknown (e.g., the trace was written to a pipe)
+    uint64_t structCount[int(Level::MAX)];      // Geometry of the device the trace was written for
+    uint8_t fieldBits[int(Level::MAX)];         // Width of each address field in the packed fields
+    uint8_t traceType;                          // Data model the data was written for (TraceType)
+    uint8_t reserved[2];
+};
+
+static const char TRACE_MAGIC[8]            = {'V', 'A', 'M', 'P', 'T', 'R', 'C', '\0'};
+static const uint32_t TRACE_VERSION         = 2;
+static const unsigned int TRACE_TYPE_BITS   = 4;
+static const unsigned int TRACE_FLAG_BITS   = 3;
+static const unsigned int TRACE_END_TYPE    = (1u << TRACE_TYPE_BITS) - 1;
+static const size_t TRACE_DATA_SIZE         = 16 * sizeof(uint32_t);
+static const size_t TRACE_MAX_VARINT_SIZE   = 10;
+
+/* Source of the data of a command in version 2 traces */
+enum class TraceData {ZERO, PAYLOAD, PREVIOUS, MAX};        // All zero, 64 bytes following, data of the previous command
+
+/* Layout of the packed fields of a trace, derived from its header */
+struct TraceLayout {
+    unsigned int shift[int(Level::MAX)];
+    uint64_t mask[int(Level::MAX)];
+    unsigned int typeShift;
+    size_t packedBytes;
+
+    /* Validates the header and derives the layout from it, exits on malformed headers */
+    explicit TraceLayout(const TraceHeader &header);
+};
+
+/*
+ * Writes commands as a version 2 binary trace. Address fields are as wide as needed for the given geometry, data is only
+ * written when it is neither zero nor the data of the previous command. The command count is filled in on close() if the output is seekable.
+ */
+class TraceWriter {
+private:
+    static const size_t BUFFER_SIZE = 1 << 20;
+
+    std::string filename;
+    int fd;
+    TraceHeader header;
+    TraceLayout layout;
+    std::vector<uint8_t> buffer;
+    uint64_t written = 0;                       // # of bytes flushed to the output
+    TraceIndexBuilder *index = nullptr;         // Indexes the output trace as it is written, if set
+    uint64_t lastIssueTime = 0;
+    alignas(64) unsigned int lastData[16] = {};
+
+    static TraceHeader make_header(const uint64_t structCount[int(Level::MAX)], TraceType traceType);
+    void flush();
+public:
+    TraceWriter(const std::string &filename, const uint64_t structCount[int(Level::MAX)], TraceType traceType);
+    ~TraceWriter();
+
+    /* Takes ownership of index, which gets the commands written and is saved next to the output on close() */
+    void setIndex(TraceIndexBuilder *index);
+    void write(const Command *cmds, size_t n);
+    void close();
+};
+
+/* Zigzag maps signed deltas to small unsigned values: 0, -1, 1, -2, ... become 0, 1, 2, 3, ... */
+static inline uint64_t zigzag_encode(int64_t value) {return ((uint64_t) value << 1) ^ (uint64_t) (value >> 63);}
+static inline int64_t zigzag_decode(uint64_t value) {return (int64_t) (value >> 1) ^ -(int64_t) (value & 1);}
+
+#endif //VAMPIRE_TRACEFORMAT_H
@@ -0,0 +1,191 @@
+/*
+
+TRACEINDEX.CPP
+
+VAMPIRE: Variation-Aware model of Memory Power Informed by Real Experiments
+https://github.com/CMU-SAFARI/VAMPIRE
+
+Copyright (c) SAFARI Research Group at Carnegie Mellon University and ETH Zürich
+Released under the MIT License
+
+*/
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sys/stat.h>
+
+#include "helper.h"
+#include "parser.h"
+#include "traceIndex.h"
+
+/* Size and modification time identify the version of a trace an index was built for */
+static bool trace_stat(const std::string &traceFilename, uint64_t &size, uint64_t &mtime) {
+    struct stat fileStat = {};
+    if (stat(traceFilename.c_str(), &fileStat) != 0 || !S_ISREG(fileStat.st_mode))
+        return false;
+
+    size = (uint64_t) fileStat.st_size;
+    mtime = (uint64_t) fileStat.st_mtim.tv_sec * 1000000000ull + (uint64_t) fileStat.st_mtim.tv_nsec;
+    return true;
+}
+
+/**********************/
+/* Class : TraceIndex */
+/**********************/
+TraceIndex *TraceIndex::load(const std::string &traceFilename, ParserType parserType, TraceType traceType) {
+    std::string filename = traceFilename + TRACE_INDEX_SUFFIX;
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open())
+        return nullptr;
+
+    auto *index = new TraceIndex();
+    TraceIndexHeader &header = index->header;
+    uint64_t traceSize = 0, traceMtime = 0;
+    std::string problem;
+
+    file.read((char *) &header, sizeof(header));
+    if (!file || memcmp(header.magic, TRACE_INDEX_MAGIC, sizeof(TRACE_INDEX_MAGIC)) != 0
+        || header.version != TRACE_INDEX_VERSION || header.headerSize < sizeof(header))
+        problem = "is not a valid index";
+    else if (!trace_stat(traceFilename, traceSize, traceMtime) || header.traceSize != traceSize
+             || header.traceMtime != traceMtime)
+        problem = "is older than the trace";
+    else if (header.parserType != uint8_t(parserType) || header.traceType != uint8_t(traceType))
+        problem = "was built for another parser or model";
+
+    if (problem.empty()) {
+        index->checkpoints.resize(header.checkpointCount);
+        index->bankStates.resize(header.checkpointCount * header.bankCount);
+        file.seekg(header.headerSize);
+        for (uint64_t pos = 0; pos < header.checkpointCount; pos++) {
+            file.read((char *) &index->checkpoints[pos], sizeof(TraceCheckpoint));
+            file.read((char *) &index->bankStates[pos * header.bankCount], header.bankCount * sizeof(TraceBankState));
+        }
+        if (!file)
+            problem = "is truncated";
+    }
+
+    if (!problem.empty()) {
+        msg::warning("Trace index `" + filename + "' " + problem + ", ignoring it.");
+        delete index;
+        return nullptr;
+    }
+    return index;
+}
+
+/* The latest issue time before a checkpoint never decreases, so the checkpoints can be bisected */
+const TraceCheckpoint *TraceIndex::find(uint64_t time) const {
+    auto after = std::partition_point(checkpoints.begin(), checkpoints.end(),
+                                      [time] (const TraceCheckpoint &checkpoint) {return checkpoint.maxIssueTime < time;});
+    return (after == checkpoints.begin()) ? nullptr : &*(after - 1);
+}
+
+const TraceBankState *TraceIndex::banks(const TraceCheckpoint &checkpoint) const {
+    return bankStates.data() + (&checkpoint - checkpoints.data()) * header.bankCount;
+}
+
+/*****************************/
+/* Class : TraceIndexBuilder */
+/*****************************/
+TraceIndexBuilder::TraceIndexBuilder(uint64_t interval, ParserType parserType, TraceType traceType) {
+    memcpy(index.header.magic, TRACE_INDEX_MAGIC, sizeof(TRACE_INDEX_MAGIC));
+    index.header.version = TRACE_INDEX_VERSION;
+    index.header.headerSize = sizeof(TraceIndexHeader);
+    index.header.interval = std::max<uint64_t>(interval, 1);
+    index.header.parserType = (uint8_t) parserType;
+    index.header.traceType = (uint8_t) traceType;
+    state.prevType = (uint32_t) CommandType::MAX;
+}
+
+void TraceIndexBuilder::add(const Command &cmd, uint64_t offset) {
+    if (state.commandIndex % index.header.interval == 0) {
+        state.offset = offset;
+        index.checkpoints.push_back(state);
+        index.bankStates.insert(index.bankStates.end(), banks.begin(), banks.end());
+        checkpointBanks.push_back(banks.size());
+    }
+
+    // Addresses are stored on 16 bits, more than the channels, ranks and banks of any device
+    uint64_t key = (uint64_t(cmd.add.channel) << 32) | (uint64_t(cmd.add.rank) << 16) | cmd.add.bank;
+    auto pos = bankPos.find(key);
+    if (pos == bankPos.end()) {
+        TraceBankState bank = {};
+        bank.channel = (uint16_t) cmd.add.channel;
+        bank.rank = (uint16_t) cmd.add.rank;
+        bank.bank = (uint16_t) cmd.add.bank;
+        pos = bankPos.emplace(key, banks.size()).first;
+        banks.push_back(bank);
+    }
+    TraceBankState &bank = banks[pos->second];
+
+    // Same bank states as the estimation: the PRE of an auto-precharge command closes the bank right away
+    switch (int(cmd.type)) {
+        case (int(CommandType::ACT)):
+            bank.open = 1;
+            bank.actRowNum = cmd.add.row;
+            break;
+        case (int(CommandType::PRE)):
+        case (int(CommandType::RDA)):
+        case (int(CommandType::WRA)):
+            bank.open = 0;
+            break;
+        default:
+            break;
+    }
+    if (cmd.type == CommandType::RD || cmd.type == CommandType::WR || cmd.type == CommandType::RDA
+        || cmd.type == CommandType::WRA) {
+        state.ioBank = (uint32_t) cmd.add.bank;
+        state.ioCol = cmd.add.col;
+        memcpy(state.ioData, cmd.data, sizeof(state.ioData));
+    }
+
+    state.commandIndex++;
+    state.maxIssueTime = std::max(state.maxIssueTime, cmd.issueTime);
+    state.prevIssueTime = cmd.issueTime;
+    state.prevType = (uint32_t) cmd.type;
+    memcpy(state.prevData, cmd.data, sizeof(state.prevData));
+}
+
+void TraceIndexBuilder::scan(Parser &parser) {
+    Command cmd;
+    uint64_t offset = parser.position();
+
+    while (parser.parse_batch(&cmd, 1) == 1) {
+        add(cmd, offset);
+        offset = parser.position();
+    }
+}
+
+bool TraceIndexBuilder::save(const std::string &traceFilename) {
+    TraceIndexHeader &header = index.header;
+    if (!trace_stat(traceFilename, header.traceSize, header.traceMtime))
+        return false;
+
+    std::string filename = traceFilename + TRACE_INDEX_SUFFIX;
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    msg::error(!file.is_open(), "Unable to write trace index `" + filename + "'.");
+
+    header.commandCount = state.commandIndex;
+    header.checkpointCount = index.checkpoints.size();
+    header.bankCount = (uint32_t) banks.size();
+    file.write((const char *) &header, sizeof(header));
+
+    // Banks first seen after a checkpoint were closed at the checkpoint
+    size_t stored = 0;
+    for (size_t pos = 0; pos < index.checkpoints.size(); pos++) {
+        file.write((const char *) &index.checkpoints[pos], sizeof(TraceCheckpoint));
+        file.write((const char *) (index.bankStates.data() + stored), checkpointBanks[pos] * sizeof(TraceBankState));
+        for (size_t bank = checkpointBanks[pos]; bank < banks.size(); bank++) {
+            TraceBankState closed = banks[bank];
+            closed.open = 0;
+            closed.actRowNum = 0;
+            file.write((const char *) &closed, sizeof(closed));
+        }
+        stored += checkpointBanks[pos];
+    }
+
+    file.close();
+    msg::error(!file, "Unable to write trace index `" + filename + "'.");
+    return true;
+}
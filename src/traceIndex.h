@@ -0,0 +1,111 @@
+/*
+
+TRACEINDEX.H
+
+VAMPIRE: Variation-Aware model of Memory Power Informed by Real Experiments
+https://github.com/CMU-SAFARI/VAMPIRE
+
+Copyright (c) SAFARI Research Group at Carnegie Mellon University and ETH Zürich
+Released under the MIT License
+
+*/
+
+#ifndef VAMPIRE_TRACEINDEX_H
+#define VAMPIRE_TRACEINDEX_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "consts.h"
+#include "command.h"
+
+class Parser;
+
+/*
+ * Sidecar index of a plain trace file (<trace>.vidx), made of checkpoints every `interval' commands. A checkpoint holds
+ * everything needed to resume parsing and estimation at the command following it: its byte offset, the previous
+ * command (whose fields the next one may carry over), the data and address of the last RD/WR and whether each bank
+ * is open and on which row. Bank states are listed in the order their banks first appear in the trace, each with its
+ * channel, rank and bank, so that the index does not depend on the geometry of the configuration. The index is only
+ * used with the trace, parser and model it was built for.
+ *
+ * File layout: <TraceIndexHeader> then, for each checkpoint, <TraceCheckpoint><TraceBankState x bankCount>.
+ */
+struct TraceIndexHeader {
+    char magic[8];                      // TRACE_INDEX_MAGIC
+    uint32_t version;                   // TRACE_INDEX_VERSION
+    uint32_t headerSize;
+    uint64_t traceSize;                 // Size and modification time (ns) of the trace, the index is stale if they differ
+    uint64_t traceMtime;
+    uint64_t interval;                  // # of commands between checkpoints
+    uint64_t commandCount;
+    uint64_t checkpointCount;
+    uint32_t bankCount;                 // # of bank states in each checkpoint
+    uint8_t parserType;                 // ParserType the offsets are valid for
+    uint8_t traceType;                  // TraceType the trace was parsed with, which decides the data carried over
+    uint8_t reserved[2];
+};
+
+struct TraceCheckpoint {
+    uint64_t commandIndex;              // # of commands before the checkpoint
+    uint64_t offset;                    // Byte offset of the command following the checkpoint
+    uint64_t maxIssueTime;              // Latest issue time of the commands before the checkpoint
+    uint64_t prevIssueTime;             // Previous command
+    uint32_t prevType;
+    uint32_t ioBank;                    // Address of the last RD/WR
+    uint64_t ioCol;
+    alignas(64) unsigned int prevData[16];
+    alignas(64) unsigned int ioData[16];    // Data of the last RD/WR
+};
+
+struct TraceBankState {
+    uint64_t actRowNum;
+    uint16_t channel;
+    uint16_t rank;
+    uint16_t bank;
+    uint16_t open;
+};
+
+static const char TRACE_INDEX_MAGIC[8]      = {'V', 'A', 'M', 'P', 'I', 'D', 'X', '\0'};
+static const uint32_t TRACE_INDEX_VERSION   = 2;       // 2: bank states hold the address of their bank
+static const std::string TRACE_INDEX_SUFFIX = ".vidx";
+
+class TraceIndex {
+public:
+    TraceIndexHeader header = {};
+    std::vector<TraceCheckpoint> checkpoints;
+    std::vector<TraceBankState> bankStates;     // header.bankCount states for each checkpoint
+
+    /* Loads the index of traceFilename, returns nullptr if there is none or if it does not match the trace */
+    static TraceIndex *load(const std::string &traceFilename, ParserType parserType, TraceType traceType);
+
+    /* Returns the last checkpoint all commands before which are issued before time, nullptr if there is none */
+    const TraceCheckpoint *find(uint64_t time) const;
+    const TraceBankState *banks(const TraceCheckpoint &checkpoint) const;
+};
+
+/*
+ * Builds a TraceIndex from the commands of a trace and the byte offsets they start at, either by scanning the trace
+ * with a parser or while a trace is written (see TraceWriter).
+ */
+class TraceIndexBuilder {
+private:
+    TraceIndex index;
+    TraceCheckpoint state = {};                 // Checkpoint at the next command
+    std::vector<TraceBankState> banks;
+    std::unordered_map<uint64_t, size_t> bankPos;   // Position in banks of each (channel, rank, bank)
+    std::vector<size_t> checkpointBanks;        // # of bank states stored for each checkpoint, the others were closed
+public:
+    TraceIndexBuilder(uint64_t interval, ParserType parserType, TraceType traceType);
+
+    /* Adds the next command of the trace, which starts at byte offset */
+    void add(const Command &cmd, uint64_t offset);
+    /* Adds all commands of the trace read by parser, which must be mapped */
+    void scan(Parser &parser);
+    /* Writes the index next to traceFilename, returns false if the trace is not a regular file */
+    bool save(const std::string &traceFilename);
+};
+
+#endif //VAMPIRE_TRACEINDEX_H
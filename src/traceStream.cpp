@@ -0,0 +1,331 @@
+/*
+
+TRACESTREAM.CPP
+
+VAMPIRE: Variation-Aware model of Memory Power Informed by Real Experiments
+https://github.com/CMU-SAFARI/VAMPIRE
+
+Copyright (c) SAFARI Research Group at Carnegie Mellon University and ETH Zürich
+Released under the MIT License
+
+*/
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAVE_LZMA
+#include <lzma.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "traceStream.h"
+#include "helper.h"
+
+/***********************/
+/* Class : TraceStream */
+/***********************/
+size_t TraceStream::read_full(uint8_t *buf, size_t size) {
+    size_t total = 0;
+    while (total < size) {
+        size_t bytes = read(buf + total, size - total);
+        if (bytes == 0)
+            break;
+        total += bytes;
+    }
+    return total;
+}
+
+TraceFormat TraceStream::detect(const uint8_t *head, size_t size) {
+    static const uint8_t GZIP_MAGIC[] = {0x1F, 0x8B, 0x08};
+    static const uint8_t XZ_MAGIC[]   = {0xFD, '7', 'z', 'X', 'Z', 0x00};
+    static const uint8_t ZSTD_MAGIC[] = {0x28, 0xB5, 0x2F, 0xFD};
+    static const uint8_t TAR_MAGIC[]  = {'u', 's', 't', 'a', 'r'};  // POSIX and GNU archives, at offset 257
+
+    auto matches = [head, size] (const uint8_t *magic, size_t length, size_t offset) -> bool {
+        return size >= offset + length && memcmp(head + offset, magic, length) == 0;
+    };
+
+    if (matches(GZIP_MAGIC, sizeof(GZIP_MAGIC), 0))
+        return TraceFormat::GZIP;
+    if (matches(XZ_MAGIC, sizeof(XZ_MAGIC), 0))
+        return TraceFormat::XZ;
+    if (matches(ZSTD_MAGIC, sizeof(ZSTD_MAGIC), 0))
+        return TraceFormat::ZSTD;
+    if (matches(TAR_MAGIC, sizeof(TAR_MAGIC), 257))
+        return TraceFormat::TAR;
+    return TraceFormat::PLAIN;
+}
+
+TraceStream *TraceStream::open(TraceStream *source, std::vector<TraceFormat> &formats) {
+    TraceStream *stream = source;
+
+    // Peel off one layer at a time, e.g., a gzip compressed tar archive is decompressed before the tar is read
+    while (true) {
+        std::vector<uint8_t> head(TAR_BLOCK_SIZE);
+        head.resize(stream->read_full(head.data(), head.size()));
+
+        TraceFormat format = detect(head.data(), head.size());
+        stream = new PrefixStream(stream, std::move(head));
+
+        switch (int(format)) {
+            case (int(TraceFormat::PLAIN)):
+                return stream;
+            case (int(TraceFormat::TAR)):
+                stream = new TarStream(stream);
+                break;
+#ifdef HAVE_ZLIB
+            case (int(TraceFormat::GZIP)):
+                stream = new GzipStream(stream);
+                break;
+#endif
+#ifdef HAVE_LZMA
+            case (int(TraceFormat::XZ)):
+                stream = new XzStream(stream);
+                break;
+#endif
+#ifdef HAVE_ZSTD
+            case (int(TraceFormat::ZSTD)):
+                stream = new ZstdStream(stream);
+                break;
+#endif
+            default:
+                msg::error("Trace is " + traceFormatString[int(format)] + " compressed, but VAMPIRE was built without "
+                           + traceFormatString[int(format)] + " support.");
+        }
+        formats.push_back(format);
+    }
+}
+
+/********************/
+/* Class : FdStream */
+/********************/
+size_t FdStream::read(uint8_t *buf, size_t size) {
+    while (true) {
+        ssize_t bytes = ::read(fd, buf, size);
+        if (bytes < 0 && errno == EINTR)
+            continue;
+        msg::error(bytes < 0, "Unable to read the trace file.");
+        return (size_t) bytes;
+    }
+}
+
+/************************/
+/* Class : PrefixStream */
+/************************/
+size_t PrefixStream::read(uint8_t *buf, size_t size) {
+    if (prefixPos == prefix.size())
+        return source->read(buf, size);
+
+    size_t bytes = std::min(size, prefix.size() - prefixPos);
+    memcpy(buf, prefix.data() + prefixPos, bytes);
+    prefixPos += bytes;
+    return bytes;
+}
+
+/*********************/
+/* Class : TarStream */
+/*********************/
+/* Skips the headers and contents of the members preceding the first regular file */
+TarStream::TarStream(TraceStream *source) : source(source) {
+    uint8_t header[TAR_BLOCK_SIZE];
+
+    while (true) {
+        if (source->read_full(header, TAR_BLOCK_SIZE) != TAR_BLOCK_SIZE
+            || std::all_of(header, header + TAR_BLOCK_SIZE, [] (uint8_t byte) {return byte == 0;})) {
+            msg::warning(true, "Tar archive does not contain any file, the trace is empty.");
+            return;
+        }
+
+        // Sizes are octal, unless the first byte has its top bit set (base-256, used by GNU tar for large files)
+        const uint8_t *sizeField = header + 124;
+        uint64_t size = 0;
+        if (sizeField[0] & 0x80) {
+            for (int byte = 1; byte < 12; byte++) {
+                size = (size << 8) | sizeField[byte];
+            }
+        } else {
+            for (int byte = 0; byte < 12 && sizeField[byte] >= '0' && sizeField[byte] <= '7'; byte++) {
+                size = (size << 3) | (sizeField[byte] - '0');
+            }
+        }
+
+        char type = (char) header[156];
+        if (type == '0' || type == '\0' || type == '7') {
+            remaining = size;
+            return;
+        }
+
+        // Not a regular file (directory, long name, pax attributes, ...), skip its padded contents
+        uint64_t toSkip = (size + TAR_BLOCK_SIZE - 1) / TAR_BLOCK_SIZE * TAR_BLOCK_SIZE;
+        while (toSkip > 0) {
+            size_t bytes = source->read_full(header, (size_t) std::min<uint64_t>(toSkip, TAR_BLOCK_SIZE));
+            msg::error(bytes == 0, "Tar archive of the trace is truncated.");
+            toSkip -= bytes;
+        }
+    }
+}
+
+size_t TarStream::read(uint8_t *buf, size_t size) {
+    if (remaining == 0)
+        return 0;
+
+    size_t bytes = source->read(buf, (size_t) std::min<uint64_t>(size, remaining));
+    msg::error(bytes == 0, "Tar archive of the trace is truncated.");
+    remaining -= bytes;
+    return bytes;
+}
+
+/****************************/
+/* Class : DecompressStream */
+/****************************/
+size_t DecompressStream::refill() {
+    size_t bytes = source->read(input.data(), input.size());
+    sourceEnded = (bytes == 0);
+    return bytes;
+}
+
+#ifdef HAVE_ZLIB
+/**********************/
+/* Class : GzipStream */
+/**********************/
+struct GzipStream::Impl {
+    z_stream stream = {};
+    bool inMember = false;                      // Part of a gzip member was decoded but not its trailer
+};
+
+GzipStream::GzipStream(TraceStream *source) : DecompressStream(source), impl(new Impl) {
+    // 15 + 32: largest window, detect the gzip or zlib header
+    msg::error(inflateInit2(&impl->stream, 15 + 32) != Z_OK, "Unable to initialize gzip decompression.");
+}
+
+GzipStream::~GzipStream() {
+    inflateEnd(&impl->stream);
+    delete impl;
+}
+
+size_t GzipStream::read(uint8_t *buf, size_t size) {
+    z_stream &stream = impl->stream;
+    size = std::min<size_t>(size, UINT32_MAX);
+    stream.next_out = buf;
+    stream.avail_out = (uInt) size;
+
+    while (stream.avail_out == size) {
+        if (stream.avail_in == 0 && !sourceEnded) {
+            stream.next_in = input.data();
+            stream.avail_in = (uInt) refill();
+        }
+
+        int status = inflate(&stream, Z_NO_FLUSH);
+        if (status == Z_STREAM_END) {
+            // Concatenated gzip members (e.g., from pigz or appended files) form a single trace
+            inflateReset(&stream);
+            impl->inMember = false;
+        } else if (status == Z_BUF_ERROR && sourceEnded && stream.avail_in == 0) {
+            msg::error(impl->inMember, "Gzip compressed trace is truncated.");
+            break;
+        } else {
+            msg::error(status != Z_OK, "Gzip compressed trace is corrupted.");
+            impl->inMember = true;
+        }
+    }
+    return size - stream.avail_out;
+}
+#endif
+
+#ifdef HAVE_LZMA
+/********************/
+/* Class : XzStream */
+/********************/
+struct XzStream::Impl {
+    lzma_stream stream = LZMA_STREAM_INIT;
+    bool ended = false;
+};
+
+XzStream::XzStream(TraceStream *source) : DecompressStream(source), impl(new Impl) {
+    msg::error(lzma_stream_decoder(&impl->stream, UINT64_MAX, LZMA_CONCATENATED) != LZMA_OK,
+               "Unable to initialize xz decompression.");
+}
+
+XzStream::~XzStream() {
+    lzma_end(&impl->stream);
+    delete impl;
+}
+
+size_t XzStream::read(uint8_t *buf, size_t size) {
+    lzma_stream &stream = impl->stream;
+    stream.next_out = buf;
+    stream.avail_out = size;
+
+    while (!impl->ended && stream.avail_out == size) {
+        if (stream.avail_in == 0 && !sourceEnded) {
+            stream.next_in = input.data();
+            stream.avail_in = refill();
+        }
+
+        // LZMA_FINISH lets the decoder check that the last stream is complete
+        lzma_ret status = lzma_code(&stream, sourceEnded ? LZMA_FINISH : LZMA_RUN);
+        if (status == LZMA_STREAM_END) {
+            impl->ended = true;
+        } else {
+            msg::error(status == LZMA_BUF_ERROR, "Xz compressed trace is truncated.");
+            msg::error(status != LZMA_OK, "Xz compressed trace is corrupted.");
+        }
+    }
+    return size - stream.avail_out;
+}
+#endif
+
+#ifdef HAVE_ZSTD
+/**********************/
+/* Class : ZstdStream */
+/**********************/
+struct ZstdStream::Impl {
+    ZSTD_DStream *stream = nullptr;
+    ZSTD_inBuffer in = {nullptr, 0, 0};
+    bool frameEnded = false;                    // The last frame decoded was complete and flushed
+};
+
+ZstdStream::ZstdStream(TraceStream *source) : DecompressStream(source), impl(new Impl) {
+    impl->stream = ZSTD_createDStream();
+    msg::error(impl->stream == nullptr || ZSTD_isError(ZSTD_initDStream(impl->stream)),
+               "Unable to initialize zstd decompression.");
+}
+
+ZstdStream::~ZstdStream() {
+    ZSTD_freeDStream(impl->stream);
+    delete impl;
+}
+
+size_t ZstdStream::read(uint8_t *buf, size_t size) {
+    ZSTD_inBuffer &in = impl->in;
+    ZSTD_outBuffer out = {buf, size, 0};
+
+    while (out.pos == 0) {
+        if (in.pos == in.size && !sourceEnded) {
+            in = {input.data(), refill(), 0};
+        }
+
+        // Consecutive frames are decoded one after the other without resetting the stream
+        size_t inPos = in.pos;
+        size_t hint = ZSTD_decompressStream(impl->stream, &out, &in);
+        msg::error(ZSTD_isError(hint), "Zstd compressed trace is corrupted.");
+        if (hint == 0)
+            impl->frameEnded = true;
+        else if (in.pos != inPos || out.pos != 0)
+            impl->frameEnded = false;
+
+        if (out.pos == 0 && sourceEnded && in.pos == in.size) {
+            msg::error(!impl->frameEnded, "Zstd compressed trace is truncated.");
+            break;
+        }
+    }
+    return out.pos;
+}
+#endif
@@ -0,0 +1,132 @@
+/*
+
+TRACESTREAM.H
+
+VAMPIRE: Variation-Aware model of Memory Power Informed by Real Experiments
+https://github.com/CMU-SAFARI/VAMPIRE
+
+Copyright (c) SAFARI Research Group at Carnegie Mellon University and ETH Zürich
+Released under the MIT License
+
+*/
+
+#ifndef VAMPIRE_TRACESTREAM_H
+#define VAMPIRE_TRACESTREAM_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* Formats of trace files recognized by their magic bytes */
+enum class TraceFormat {PLAIN, GZIP, XZ, ZSTD, TAR, MAX};
+const std::string traceFormatString[] = {"plain", "gzip", "xz", "zstd", "tar"};
+
+/*
+ * Sequential source of trace bytes. Compressed traces and tar archives are decoded on the fly by stacking streams on
+ * top of the one reading the file, so that they never have to be inflated to disk.
+ */
+class TraceStream {
+public:
+    virtual ~TraceStream() = default;
+
+    /* Reads up to size bytes into buf, returns 0 at the end of the stream */
+    virtual size_t read(uint8_t *buf, size_t size) = 0;
+
+    /* Reads until buf is full or the stream ends, returns the # of bytes read */
+    size_t read_full(uint8_t *buf, size_t size);
+
+    /* Detects the format of a trace from its first bytes (at least TAR_BLOCK_SIZE of them to recognize tar) */
+    static TraceFormat detect(const uint8_t *head, size_t size);
+
+    /* Returns a stream of the trace contents read from source (which it takes ownership of), after removing any layer
+     * of compression and taking the first file of a tar archive. The formats found are appended to formats */
+    static TraceStream *open(TraceStream *source, std::vector<TraceFormat> &formats);
+
+    static const size_t TAR_BLOCK_SIZE = 512;
+};
+
+/* Reads a file descriptor, which is not closed */
+class FdStream : public TraceStream {
+private:
+    int fd;
+public:
+    explicit FdStream(int fd) : fd(fd) {};
+    size_t read(uint8_t *buf, size_t size) override;
+};
+
+/* Returns bytes that were already read from a stream (e.g., to detect its format) before the rest of the stream */
+class PrefixStream : public TraceStream {
+private:
+    TraceStream *source;
+    std::vector<uint8_t> prefix;
+    size_t prefixPos = 0;
+public:
+    PrefixStream(TraceStream *source, std::vector<uint8_t> prefix) : source(source), prefix(std::move(prefix)) {};
+    ~PrefixStream() override {delete source;};
+    size_t read(uint8_t *buf, size_t size) override;
+};
+
+/* Contents of the first regular file of a tar archive */
+class TarStream : public TraceStream {
+private:
+    TraceStream *source;
+    uint64_t remaining = 0;                     // Bytes left in the member being read
+public:
+    explicit TarStream(TraceStream *source);
+    ~TarStream() override {delete source;};
+    size_t read(uint8_t *buf, size_t size) override;
+};
+
+/* Base of the decompressing streams, holds the compressed input read from the source */
+class DecompressStream : public TraceStream {
+protected:
+    static const size_t INPUT_SIZE = 1 << 18;
+
+    TraceStream *source;
+    std::vector<uint8_t> input;
+    bool sourceEnded = false;
+
+    /* Refills the input with the next compressed bytes, returns the # of bytes read */
+    size_t refill();
+public:
+    explicit DecompressStream(TraceStream *source) : source(source), input(INPUT_SIZE) {};
+    ~DecompressStream() override {delete source;};
+};
+
+#ifdef HAVE_ZLIB
+class GzipStream : public DecompressStream {
+private:
+    struct Impl;
+    Impl *impl;
+public:
+    explicit GzipStream(TraceStream *source);
+    ~GzipStream() override;
+    size_t read(uint8_t *buf, size_t size) override;
+};
+#endif
+
+#ifdef HAVE_LZMA
+class XzStream : public DecompressStream {
+private:
+    struct Impl;
+    Impl *impl;
+public:
+    explicit XzStream(TraceStream *source);
+    ~XzStream() override;
+    size_t read(uint8_t *buf, size_t size) override;
+};
+#endif
+
+#ifdef HAVE_ZSTD
+class ZstdStream : public DecompressStream {
+private:
+    struct Impl;
+    Impl *impl;
+public:
+    explicit ZstdStream(TraceStream *source);
+    ~ZstdStream() override;
+    size_t read(uint8_t *buf, size_t size) override;
+};
+#endif
+
+#endif //VAMPIRE_TRACESTREAM_H
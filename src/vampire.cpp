@@ -11,6 +11,9 @@ Released under the MIT License
 */
 
 #include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <thread>
 #include "vampire.h"
 #include "command.h"
 
@@ -26,10 +29,14 @@ Vampire::~Vampire() {
 
     delete configs;
     delete parser;
+    delete traceWriter;
 
     delete traceFilename;
     delete configFilename;
     delete dramSpecFilename;
+    delete memImageInFilename;
+    delete memImageOutFilename;
+    delete traceOutFilename;
 
     delete dramSpec;
     delete dramStruct;
@@ -40,53 +47,34 @@ Vampire::~Vampire() {
 }
 
 /*
- * Initializes all the lambda arrays declared in src/vampire.h, these lambda arrays are arrays of functions for different
- * tasks like calculating # of set/toggle bits & initializing data structures. Each element of these arrays corresponds to
- * one of the traceType, thus only one of the element of each array is called during runtime.
+ * Initializes all the lambda arrays declared in src/vampire.h, these lambda arrays are arrays of functions for
+ * initializing and freeing data structures. Each element of these arrays corresponds to one of the traceType, thus only
+ * one of the element of each array is called during runtime.
  */
 void Vampire::init_lambdas(){
     /*****************************************************************************************/
     /* Create lambdas which allocates memory for all the data structures used by a TraceType */
     /*****************************************************************************************/
     init_structures[int(TraceType::WR)] = [this] () -> void {
-        unsigned long channel, rank, bank, row, col;
-        memory = (DRAMdata *****) malloc(sizeof(class DRAMdata ****) * configs->getNumChannels());
-
-        for (channel = 0; channel < configs->getNumChannels(); channel++){
-            memory[channel] = (DRAMdata ****) malloc(sizeof(class DRAMdata ***) * configs->getNumRanks());
-        }
-        for (channel = 0; channel < configs->getNumChannels(); channel++){
-            for (rank = 0; rank < configs->getNumRanks(); rank++){
-                memory[channel][rank] = (DRAMdata ***) malloc(sizeof(class DRAMdata **) * configs->getNumBanks());
-            }
-        }
-        for (channel = 0; channel < configs->getNumChannels(); channel++){
-            for (rank = 0; rank < configs->getNumRanks(); rank++){
-                for (bank = 0; bank < configs->getNumBanks(); bank++){
-                    memory[channel][rank][bank] = (DRAMdata **) malloc(sizeof(class DRAMdata *) * configs->getNumRows());
-                }
-            }
-        }
-        for (channel = 0; channel < configs->getNumChannels(); channel++){
-            for (rank = 0; rank < configs->getNumRanks(); rank++){
-                for (bank = 0; bank < configs->getNumBanks(); bank++){
-                    for (row = 0; row < configs->getNumRows(); row++){
-                        memory[channel][rank][bank][row] = (DRAMdata *) malloc(sizeof(class DRAMdata) * configs->getNumCols());
-                    }
-                }
-            }
-        }
-        for (channel = 0; channel < configs->getNumChannels(); channel++){
-            for (rank = 0; rank < configs->getNumRanks(); rank++){
-                for (bank = 0; bank < configs->getNumBanks(); bank++){
-                    for (row = 0; row < configs->getNumRows(); row++){
-                        for (col = 0; col < configs->getNumCols(); col++){
-                            memory[channel][rank][bank][row][col].init_values();
-                        }
-                    }
-                }
-            }
+        switch (int(memImageType)) {
+            case (int(MemImageType::FLAT)):
+                memory = new FlatMemoryImage(*configs);
+                break;
+            case (int(MemImageType::DEDUP)):
+                memory = new DedupMemoryImage(*configs);
+                break;
+            case (int(MemImageType::COMPRESSED)):
+                memory = new CompressedMemoryImage(*configs);
+                break;
+            default:
+                if (memLimit != 0)
+                    memory = new SpillingMemoryImage(*configs, memLimit);
+                else
+                    memory = new SparseMemoryImage(*configs);
         }
+
+        if (memImageInFilename != nullptr)
+            memory->load(*memImageInFilename);
     };
     init_structures[int(TraceType::RD_WR)] = [this] () -> void {
         return;
@@ -129,7 +117,7 @@ void Vampire::init_lambdas(){
                          + " values will be initialized randomly.");
 
             for (; setBitArrPtr < (NUM_OF_BITS+1)*NUM_OF_SET_BIT_ARR_MULT; setBitArrPtr++) {
-                numOfSetBits->operator[]((unsigned long)setBitArrPtr) = (unsigned short)(rand() % (NUM_OF_BITS));
+                numOfSetBits->operator[]((unsigned long)setBitArrPtr) = (unsigned short)(draw_random() % (NUM_OF_BITS));
             }
         }
 
@@ -162,7 +150,7 @@ void Vampire::init_lambdas(){
                        + " values will be initialized randomly.");
 
             for (; toggleBitArrPtr < (NUM_OF_BITS+1)*TOGGLE_BIT_ARR_MULT; toggleBitArrPtr++) {
-                numOfToggleBits->operator[]((unsigned long)toggleBitArrPtr) = (unsigned short)(rand() % (NUM_OF_BITS));
+                numOfToggleBits->operator[]((unsigned long)toggleBitArrPtr) = (unsigned short)(draw_random() % (NUM_OF_BITS));
             }
         }
     };
@@ -170,90 +158,11 @@ void Vampire::init_lambdas(){
 
     };
 
-    /*************************************************************************/
-    /* Initialize function to calculate # of set bits depending on traceType */
-    /*************************************************************************/
-    getSetBits[int(TraceType::MEAN)] = [this] (unsigned int data[16]) -> unsigned int {
-        static_cast<void>(data); // Avoids compiler warning -Wunused-parameter
-
-        return (unsigned int) configs->getAvgNumSetBits();
-    };
-    getSetBits[int(TraceType::DIST)] = [this] (unsigned int data[16]) -> unsigned int {
-        static_cast<void>(data); // Avoids compiler warning -Wunused-parameter
-
-        // Pick the value from the array based on a rnd number, probability of a
-        // value being picked is proportional to its frequency
-        msg::warning(RAND_MAX > rand()%((NUM_OF_BITS+1) * configs->getSetBitArrSizeMult()),
-                   "Maximum random number that can be generated exceeds the length of the array used for internal representation of setBitArr,"
-                   " consider reducing the value of '" + AVG_SET_BITS_S + "'");
-        unsigned int result = numOfSetBits->operator[]((unsigned long)(rand()%((NUM_OF_BITS+1) * configs->getSetBitArrSizeMult())));
-        dist->operator[](result)++;
-        return result;
-    };
-    getSetBits[int(TraceType::WR)] = [this] (unsigned int data[16]) -> unsigned int {
-        unsigned int count = 0;
-
-        for (int fourbytes = 0; fourbytes < 16; fourbytes++){
-            count += __builtin_popcount(data[fourbytes]);
-        }
-        return count;
-    };
-    getSetBits[int(TraceType::RD_WR)] = [this] (unsigned int data[16]) -> unsigned int {
-        return getSetBits[int(TraceType::WR)](data); // Same as
-    };
-    
-    /****************************************************************************/
-    /* Initialize function to calculate # of toggle bits depending on traceType */
-    /****************************************************************************/
-    getToggleBits[int(TraceType::WR)] = [this] (unsigned int new_data[16], unsigned int old_data[16])
-            -> unsigned int {
-        unsigned int toggle_count = 0;
-
-        for(int fourbytes = 0; fourbytes < 16; fourbytes++){
-            toggle_count += __builtin_popcount(old_data[fourbytes] ^ new_data[fourbytes]);
-        }
-        return toggle_count;
-    };
-    getToggleBits[int(TraceType::RD_WR)] = [this] (unsigned int new_data[16], unsigned int old_data[16])
-            -> unsigned int {
-        return getToggleBits[int(TraceType::WR)](new_data, old_data);
-    };
-    getToggleBits[int(TraceType::MEAN)] = [this] (unsigned int new_data[16], unsigned int old_data[16])
-            -> unsigned int {
-        static_cast<void>(new_data); // Avoids compiler warning -Wunused-parameter
-        static_cast<void>(old_data); // Avoids compiler warning -Wunused-parameter
-
-        return (unsigned int) configs->getAvgNumToggleBits();
-    };
-    getToggleBits[int(TraceType::DIST)] = [this] (unsigned int new_data[16], unsigned int old_data[16])
-            -> unsigned int {
-        static_cast<void>(new_data); // Avoids compiler warning -Wunused-parameter
-        static_cast<void>(old_data); // Avoids compiler warning -Wunused-parameter
-
-        // Pick the value from the array based on a rnd number, probability of a
-        // value being picked is proportional to its frequency
-        return numOfToggleBits->operator[](rand()%((NUM_OF_BITS+1) * configs->getSetBitArrSizeMult()));
-    };
-
     /***********************************************************************************/
     /* Initializes the lambdas which frees up data structures created by init_struct() */
     /***********************************************************************************/
     free_structures[int(TraceType::WR)] = [this] () {
-        unsigned long channel, rank, bank, row;
-
-        for (channel = 0; channel < configs->getNumChannels(); channel++){
-            for (rank = 0; rank < configs->getNumRanks(); rank++){
-                for (bank = 0; bank < configs->getNumBanks(); bank++){
-                    for (row = 0; row < configs->getNumRows(); row++){
-                        free(memory[channel][rank][bank][row]);
-                    }
-                    free(memory[channel][rank][bank]);
-                }
-                free(memory[channel][rank]);
-            }
-            free(memory[channel]);
-        }
-        free(memory);
+        delete memory;
     };
     free_structures[int(TraceType::RD_WR)] = [this] () {
         return;
@@ -267,6 +176,68 @@ void Vampire::init_lambdas(){
     };
 }
 
+/*********************************************************/
+/* # of set and toggle bits in a cache line by traceType */
+/*********************************************************/
+template <>
+unsigned int Vampire::set_bits<TraceType::MEAN>(unsigned int data[16]) {
+    static_cast<void>(data); // Avoids compiler warning -Wunused-parameter
+
+    return (unsigned int) configs->getAvgNumSetBits();
+}
+
+template <>
+unsigned int Vampire::set_bits<TraceType::DIST>(unsigned int data[16]) {
+    static_cast<void>(data); // Avoids compiler warning -Wunused-parameter
+
+    // Pick the value from the array based on a rnd number, probability of a
+    // value being picked is proportional to its frequency
+    msg::warning(RAND_MAX > draw_random()%((NUM_OF_BITS+1) * configs->getSetBitArrSizeMult()),
+               "Maximum random number that can be generated exceeds the length of the array used for internal representation of setBitArr,"
+               " consider reducing the value of '" + AVG_SET_BITS_S + "'");
+    unsigned int result = numOfSetBits->operator[]((unsigned long)(draw_random()%((NUM_OF_BITS+1) * configs->getSetBitArrSizeMult())));
+    dist->operator[](result)++;
+    return result;
+}
+
+template <>
+unsigned int Vampire::set_bits<TraceType::WR>(unsigned int data[16]) {
+    return noSetBits(data);
+}
+
+template <>
+unsigned int Vampire::set_bits<TraceType::RD_WR>(unsigned int data[16]) {
+    return set_bits<TraceType::WR>(data); // Same as WR
+}
+
+template <>
+unsigned int Vampire::toggle_bits<TraceType::WR>(unsigned int new_data[16], unsigned int old_data[16]) {
+    return toggle(new_data, old_data);
+}
+
+template <>
+unsigned int Vampire::toggle_bits<TraceType::RD_WR>(unsigned int new_data[16], unsigned int old_data[16]) {
+    return toggle_bits<TraceType::WR>(new_data, old_data);
+}
+
+template <>
+unsigned int Vampire::toggle_bits<TraceType::MEAN>(unsigned int new_data[16], unsigned int old_data[16]) {
+    static_cast<void>(new_data); // Avoids compiler warning -Wunused-parameter
+    static_cast<void>(old_data); // Avoids compiler warning -Wunused-parameter
+
+    return (unsigned int) configs->getAvgNumToggleBits();
+}
+
+template <>
+unsigned int Vampire::toggle_bits<TraceType::DIST>(unsigned int new_data[16], unsigned int old_data[16]) {
+    static_cast<void>(new_data); // Avoids compiler warning -Wunused-parameter
+    static_cast<void>(old_data); // Avoids compiler warning -Wunused-parameter
+
+    // Pick the value from the array based on a rnd number, probability of a
+    // value being picked is proportional to its frequency
+    return numOfToggleBits->operator[](draw_random()%((NUM_OF_BITS+1) * configs->getSetBitArrSizeMult()));
+}
+
 void Vampire::init_latencies() {
 /*    // RD, WR, ACT, PRE
     latency[int(VendorType::A)].assign({
@@ -280,6 +251,20 @@ void Vampire::init_latencies() {
     });*/
 }
 
+/* The structural variation of RD is only known for the banks vendors A, B and C were measured on */
+static void check_struct_var(VendorType vendorType, StructVar structVar, const Config &configs) {
+    if (structVar != StructVar::YES)
+        return;
+
+    if (vendorType == VendorType::Cust) {
+        msg::error("Structural variation is not supported with the Cust vendor, see vampire --help for more details.");
+    }
+    if (configs.getNumBanks() > Equations::STRUCT_VAR_BANKS) {
+        msg::error("Structural variation is only supported with up to " + std::to_string(Equations::STRUCT_VAR_BANKS)
+                   + " banks, see vampire --help for more details.");
+    }
+}
+
 /* Intializes all the objects used in VAMPIRE class. Called after parsing config file and command line parameters */
 int Vampire::set_values(){
     dist = new std::vector<int>(NUM_OF_BITS+1);
@@ -289,52 +274,262 @@ int Vampire::set_values(){
     IO_buffer.init_values();
     
     /* Initialize parser to parse the trace file */
-    if (parserType == ParserType::ASCII)
-        parser = new AsciiParser();
-    else if (parserType == ParserType::BINARY)
-        parser = new BinParser();
+    if (parserType == ParserType::ASCII && parseThreads > 0)
+        parser = new ParallelAsciiParser(parseThreads, PARSE_CHUNK_SIZE);
     else
-        msg::error("Unkonwn parser type.");
+        parser = new_parser();
+
+    if (parseThreads > 0 && parserType != ParserType::ASCII) {
+        msg::error("Parsing on multiple threads is only supported for ASCII traces, see vampire --help for more details.");
+    }
 
     if (traceFilename == nullptr) {
         msg::error("No trace found, please specify a trace file. See 'vampire --help' for more details.");
     }
 
+    parser->setFollow(follow, followTimeout);
+    parser->setDirectIO(directIO);
     parser->setFilename(*traceFilename);
     parser->setTraceType(traceType);
 
+    parser->setSelection(selection);
+    windowStart = std::max(windowStart, selection.time.first);
+    windowEnd = std::min(windowEnd, selection.time.last);
+
+    if (windowStart > windowEnd) {
+        msg::error("The window starts after it ends, see vampire --help for more details.");
+    }
+
+    if ((memImageInFilename != nullptr || memImageOutFilename != nullptr) && traceType != TraceType::WR) {
+        msg::error("Memory image snapshots are only supported by the WR model, see vampire --help for more details.");
+    }
+
+    if (parallelLevel != Level::MAX
+        && (traceOutFilename != nullptr || memImageInFilename != nullptr || memImageOutFilename != nullptr)) {
+        msg::error("-traceOut and memory image snapshots are not supported when estimating in parallel, see vampire --help "
+                   "for more details.");
+    }
+
+    // Segments start from the checkpoints of the whole trace, each of them holds every command after its checkpoint
+    if (segments > 1 && (parallelLevel != Level::MAX || selection.isSelective() || windowStart > 0
+                         || windowEnd != UINT64_MAX || follow || traceOutFilename != nullptr)) {
+        msg::error("Time segments are not supported with -parallel, -select, -from, -to, -follow or -traceOut, see "
+                   "vampire --help for more details.");
+    }
+
+    if (!sweep.empty() && (parallelLevel != Level::MAX || segments > 1 || traceOutFilename != nullptr
+                           || memImageInFilename != nullptr || memImageOutFilename != nullptr)) {
+        msg::error("Sweeps are not supported with -parallel, -segments, -traceOut and memory image snapshots, see "
+                   "vampire --help for more details.");
+    }
+
+    check_struct_var(vendorType, structVar, *configs);
+    for (auto &sweepConfig : sweep) {
+        check_struct_var(sweepConfig.vendorType, sweepConfig.structVar, *configs);
+    }
+
+    if (memLimit != 0 && memImageType != MemImageType::SPARSE) {
+        msg::error("A memory limit is only supported by the SPARSE memory image, see vampire --help for more details.");
+    }
+
     /* Initialize all the vendor specific info */
+    dramSpec = new_dram_spec(vendorType, dramSpecFilename);
+
+    /* Initialize all the statistics */
+    statistics = new Statistics(configs->structCount, this->csvFilename);
+
+    if (traceOutFilename != nullptr)
+        traceWriter = new TraceWriter(*traceOutFilename, configs->structCount, traceType);
+
+    if (traceOutFilename != nullptr && buildIndex)
+        traceWriter->setIndex(new TraceIndexBuilder(indexInterval, ParserType::BINARY, traceType));
+
+    equations = new Equations(*statistics, *dramSpec, *configs, vendorType, traceType, structVar);
+    dramStruct = new DramStruct(*configs);
+    for (auto &rank : dramStruct->ranks) {
+        rank.lastStandbyEnergyEvalTime = windowStart;
+    }
+
+    if (buildIndex)
+        build_index();
+    // Checkpoints hold the IO state of the whole trace rather than of each partition, which warm up from the start
+    if (windowStart > 0 && parallelLevel == Level::MAX)
+        seek_window();
+
+    // Move decoding to its own thread, the parser only has to be set up and positioned beforehand
+    if (parseDepth > 0)
+        parser = new AsyncParser(parser, parseDepth, parseBatchSize);
+
+    return 0;
+}
+
+Parser *Vampire::new_parser() const {
+    switch (int(parserType)) {
+        case (int(ParserType::BINARY)):
+            return new BinParser();
+        case (int(ParserType::ASCII)):
+            return new AsciiParser();
+        case (int(ParserType::RAMULATOR)):
+            return new RamulatorParser();
+        case (int(ParserType::DRAMSIM3)):
+            return new DramSim3Parser();
+        case (int(ParserType::DRAMPOWER)):
+            return new DramPowerParser();
+        default:
+            msg::error("Unkonwn parser type.");
+            return nullptr;
+    }
+}
+
+DramSpec *Vampire::new_dram_spec(VendorType vendorType, const std::string *dramSpecFilename) const {
     switch (int(vendorType)) {
-        case (int(VendorType::A)): {
-            dramSpec = new DramSpec_A();
-            break;
-        }
-        case (int(VendorType::B)): {
-            dramSpec = new DramSpec_B();
-            break;
-        }
-        case (int(VendorType::C)): {
-            dramSpec = new DramSpec_C();
-            break;
-        }
-        case (int(VendorType::Cust)) : {
+        case (int(VendorType::A)):
+            return new DramSpec_A();
+        case (int(VendorType::B)):
+            return new DramSpec_B();
+        case (int(VendorType::C)):
+            return new DramSpec_C();
+        default:
             if (dramSpecFilename == nullptr) {
                 msg::error("No dramSpec file specified with Cust Vender, see vampire --help for more details.");
             }
-            dramSpec = new DramSpec_Cust(*dramSpecFilename);
-        }
+            return new DramSpec_Cust(*dramSpecFilename);
     }
+}
 
-    /* Initialize all the statistics */
-    statistics = new Statistics(configs->structCount, this->csvFilename);
-    equations = new Equations(*statistics, *dramSpec, *configs, vendorType, traceType, &memory, structVar);
-    dramStruct = new DramStruct();
-    return 0;
+void Vampire::build_index() {
+    if (!parser->isMapped()) {
+        msg::warning("Only plain trace files can be indexed, `" + *traceFilename + "' was not indexed.");
+        return;
+    }
+    // Checkpoints do not hold the banks an imported PREA closes, convert the trace with -traceOut -buildIndex instead
+    if (parserType != ParserType::BINARY && parserType != ParserType::ASCII) {
+        msg::warning("Traces of other simulators cannot be indexed, `" + *traceFilename + "' was not indexed.");
+        return;
+    }
+
+    Parser *scanner = new_parser();
+    scanner->setFilename(*traceFilename);
+    scanner->setTraceType(traceType);
+
+    TraceIndexBuilder builder(indexInterval, parserType, traceType);
+    builder.scan(*scanner);
+    builder.save(*traceFilename);
+    msg::info("Trace index written to `" + *traceFilename + TRACE_INDEX_SUFFIX + "'");
+    delete scanner;
+}
+
+/* Command before checkpoint, whose fields the command after it may carry over */
+static Command checkpoint_command(const TraceCheckpoint &checkpoint) {
+    Command previous;
+    previous.type = (CommandType) checkpoint.prevType;
+    previous.issueTime = checkpoint.prevIssueTime;
+    memcpy(previous.data, checkpoint.prevData, sizeof(previous.data));
+    return previous;
+}
+
+/* Without an index (or a usable checkpoint), estimate() reaches the window by warming up from the start of the trace */
+void Vampire::seek_window() {
+    // The memory image of the WR model needs every write before the window, only mapped traces can be seeked
+    if (traceType == TraceType::WR || !parser->isMapped())
+        return;
+
+    TraceIndex *index = TraceIndex::load(*traceFilename, parserType, traceType);
+    if (index == nullptr)
+        return;
+
+    const TraceCheckpoint *checkpoint = index->find(windowStart);
+    if (checkpoint != nullptr && parser->seek(checkpoint->offset, checkpoint_command(*checkpoint))) {
+        restore_checkpoint(*index, *checkpoint);
+        msg::info("Resuming the trace at command #" + std::to_string(checkpoint->commandIndex) + " (byte "
+                  + std::to_string(checkpoint->offset) + ") from its index");
+    }
+    delete index;
+}
+
+void Vampire::restore_checkpoint(const TraceIndex &index, const TraceCheckpoint &checkpoint) {
+    // Banks outside of the geometry of the configuration are left out, their commands are rejected anyway
+    const TraceBankState *banks = index.banks(checkpoint);
+    for (uint64_t pos = 0; pos < index.header.bankCount; pos++) {
+        MappedAdd add(banks[pos].channel, banks[pos].rank, banks[pos].bank, 0, 0);
+        if (add.channel >= configs->getNumChannels() || add.rank >= configs->getNumRanks()
+            || add.bank >= configs->getNumBanks())
+            continue;
+
+        uint64_t bank = dramStruct->bankIndex(add);
+        dramStruct->setBankState(bank, banks[pos].open ? State::OPEN : State::CLOSE);
+        dramStruct->banks[bank].actRowNum = banks[pos].actRowNum;
+    }
+
+    IO_buffer.prevAdd.bank = checkpoint.ioBank;
+    IO_buffer.prevAdd.col = checkpoint.ioCol;
+    if (traceType == TraceType::RD_WR)
+        memcpy(IO_buffer.data, checkpoint.ioData, sizeof(IO_buffer.data));
+}
+
+void Vampire::warm_up(Command &cmd) {
+    int encoding = 0;
+
+    Helper::verify_add(cmd.type, cmd.add, *configs);
+
+    uint64_t bankNum = dramStruct->bankIndex(cmd.add);
+    auto &bank = dramStruct->banks[bankNum];
+    bool isRdCmd = cmd.type == CommandType::RD || cmd.type == CommandType::RDA;
+    bool isWrCmd = cmd.type == CommandType::WR || cmd.type == CommandType::WRA;
+
+    // The PRE of an auto-precharge command closes the bank right away
+    if (cmd.type == CommandType::ACT) {
+        dramStruct->setBankState(bankNum, State::OPEN);
+        bank.actRowNum = cmd.add.row;
+    } else if (cmd.type == CommandType::PRE || cmd.type == CommandType::RDA || cmd.type == CommandType::WRA) {
+        dramStruct->setBankState(bankNum, State::CLOSE);
+    }
+
+    if (!isRdCmd && !isWrCmd)
+        return;
+
+    if (cmd.hasData && encodingType != EncodingType::NONE)
+        apply_encoding(cmd.type, cmd.data, encoding);
+
+    // Lines are written unencoded, as estimate() services every command with service_request(0, cmd)
+    if (traceType == TraceType::WR && isWrCmd) {
+        memory->write(cmd.add, cmd.data, 0);
+        memcpy(IO_buffer.data, cmd.data, sizeof(IO_buffer.data));
+    } else if (traceType == TraceType::WR) {
+        unsigned int lineEncoded;
+        memcpy(IO_buffer.data, memory->read(cmd.add, lineEncoded).data, sizeof(IO_buffer.data));
+    } else if (traceType == TraceType::RD_WR) {
+        memcpy(IO_buffer.data, cmd.data, sizeof(IO_buffer.data));
+    }
+    IO_buffer.prevAdd.bank = cmd.add.bank;
+    IO_buffer.prevAdd.col = cmd.add.col;
 }
 
-/* Function to find and add energy consumed by a request. Returns 0 if sucessful.
-   Else returns -1*/
-int Vampire::service_request(int encoded, Command cmd) {
+void Vampire::add_standby_energy(DramStruct::Rank &rank, uint64_t time) {
+    // The rank stands by from the end of the segment before, which is only known once it is estimated
+    if (rank.lastStandbyEnergyEvalTime == DramStruct::Rank::DEFERRED)
+        rank.firstStandbyEvalTime = time;
+    auto timeDiff = (time > rank.lastStandbyEnergyEvalTime) ? time - rank.lastStandbyEnergyEvalTime : 0;
+
+    dbgstream
+            << "rank: " << rank.channel << "/" << rank.rank
+            << ", time: " << time
+            << ", timeDiff: " << timeDiff << std::endl;
+
+    if (rank.openBankCount == 0) {
+        *statistics->totalPrechargeStandbyEnergy += timeDiff*dramSpec->preStandbyEnergy;
+        *statistics->totalPreStandbyCycles += timeDiff;
+    } else {
+        *statistics->totalActiveStandbyEnergy += timeDiff*dramSpec->actStandbyEnergy;
+        *statistics->totalActStandbyCycles += timeDiff;
+    }
+
+    rank.lastStandbyEnergyEvalTime = time;
+}
+
+/* Function to find and add energy consumed by a request */
+template <TraceType traceT, VendorType vendorT, StructVar structVarT>
+void Vampire::service_request(int encoded, Command cmd) {
     msg::error(cmd.finishTime == 0, "Finish time is 0.");
 
     uint32_t fourbytes;
@@ -342,20 +537,12 @@ int Vampire::service_request(int encoded, Command cmd) {
     Helper::verify_add(cmd.type, cmd.add, *configs);
 
     auto &cmdLength             =  dramSpec->getCmdLength();
-    auto &cmdCurrent            =  dramSpec->getCmdCurrent();
     auto &memClkSpeed           =  dramSpec->memClkSpeed;
 
     auto &totalReadEnergy       = *statistics->totalReadEnergy;
     auto &totalWriteEnergy      = *statistics->totalWriteEnergy;
     auto &totalActCmdEnergy     = *statistics->totalActCmdEnergy;
     auto &totalPreCmdEnergy     = *statistics->totalPreCmdEnergy;
-    auto &totalActiveEnergy     = *statistics->totalActiveStandbyEnergy;
-    auto &totalPrechargeEnergy  = *statistics->totalPrechargeStandbyEnergy;
-
-    auto &totalActStandbyCycles = *statistics->totalActStandbyCycles;
-    auto &totalPreStandbyCycles = *statistics->totalPreStandbyCycles;
-
-    auto &vdd                   = dramSpec->vdd;
 
     auto cmdLengthInCycles = [&] (CommandType cmdType) -> uint64_t {
         return static_cast<uint64_t>(
@@ -364,32 +551,10 @@ int Vampire::service_request(int encoded, Command cmd) {
 
     this->currentTime = cmd.issueTime;
 
-    /* Calculate # of cycles for idle state for the current bank */
-    bool allBankPrecharged = true;
-
-    auto timeDiff = (currentTime > lastStandbyEnergyEvalTime) ? currentTime - lastStandbyEnergyEvalTime : 0;
-    /* Cycle through all the banks to check if anyone of them was open */
-    for (uint64_t i = 0; i < dramStruct->banks->size(); i++) {
-        auto &bank = dramStruct->banks->operator[](i);
-        auto &bankState = dramStruct->bankStates->operator[](i);
-
-        if (timeDiff && dramStruct->bankStates->operator[](i) == State::OPEN)
-            allBankPrecharged = false;
-    }
-
-    dbgstream
-            << "currentTime: " << currentTime
-            << ", timeDiff: " << timeDiff << std::endl;
-
-    if (allBankPrecharged) {
-        totalPrechargeEnergy += timeDiff*dramSpec->preStandbyEnergy;
-        totalPreStandbyCycles += timeDiff;
-    } else {
-        totalActiveEnergy += timeDiff*dramSpec->actStandbyEnergy;
-        totalActStandbyCycles += timeDiff;
-    }
-
-    this->lastStandbyEnergyEvalTime = this->currentTime;
+    /* Calculate # of cycles for idle state for the rank of the command */
+    uint64_t bankNum = dramStruct->bankIndex(cmd.add);
+    auto &bank = dramStruct->banks[bankNum];
+    add_standby_energy(dramStruct->rankOf(bankNum), currentTime);
 
 #ifdef GLOBAL_DEBUG
     std::stringstream ss;
@@ -401,17 +566,16 @@ int Vampire::service_request(int encoded, Command cmd) {
     // TODO: Refactor - split into multiple methods
     switch (int(cmd.type)) {
         case (int(CommandType::RD)): {
-            msg::warning(dramStruct->bankStates->operator[](cmd.add.bank) != State::OPEN,
+            msg::warning(dramStruct->bankStates[bankNum] != State::OPEN,
                        "RD/RDA called on closed bank at time: " + std::to_string(cmd.issueTime));
 
-            /* Gets the # of set and toggle bits using the lambda corresponding to the current traceType */
-            auto numOfSetBits = getSetBits[int(traceType)](cmd.data);
-            auto numOfToggleBits = getToggleBits[int(traceType)](cmd.data, IO_buffer.data);
+            auto numOfSetBits = set_bits<traceT>(cmd.data);
+            auto numOfToggleBits = toggle_bits<traceT>(cmd.data, IO_buffer.data);
 
             // Correct row address of the command since it isn't read from the trace for a PRE
-            cmd.add.row = dramStruct->banks->operator[](cmd.add.bank)->actRowNum;
+            cmd.add.row = bank.actRowNum;
 
-            double_t cmdRdEnergy = equations->calc_rd_wr_energy(
+            double_t cmdRdEnergy = equations->calc_rd_wr_energy<vendorT>(
                     CommandType::RD,
                     cmd.add,
                     cmd.data,
@@ -423,7 +587,7 @@ int Vampire::service_request(int encoded, Command cmd) {
 
             dbgstream
                     << ", cmdLengthInCycles: " << dramSpec->cmdLengthInCycles(CommandType::RD)
-                    << ", cmdRdEnergy: " << equations->calc_rd_wr_energy(CommandType::RD, cmd.add, cmd.data, numOfSetBits, numOfToggleBits, IO_buffer, encodingType)
+                    << ", cmdRdEnergy: " << equations->calc_rd_wr_energy<vendorT>(CommandType::RD, cmd.add, cmd.data, numOfSetBits, numOfToggleBits, IO_buffer, encodingType)
                     << ", cmdRdEnergy - bgEnergy" << cmdRdEnergy
                     << ", RDCmdLength: " << dramSpec->cmdLengthInCycles(CommandType::RD)
                     << ", cmdLength: " << cmdLength[static_cast<uint64_t>(CommandType::RD)]
@@ -431,19 +595,21 @@ int Vampire::service_request(int encoded, Command cmd) {
 
 
             cmdRdEnergy /= 2; // Current model uses the standard IDD4 loops which have RD/WR energies of two command
-            if (structVar == StructVar::YES)
-                totalReadEnergy += cmdRdEnergy * equations->struct_var_power_adjustment(CommandType::RD, cmd.add);
+            if (structVarT == StructVar::YES)
+                totalReadEnergy += cmdRdEnergy * equations->struct_var_power_adjustment<vendorT>(CommandType::RD, cmd.add);
             else
                 totalReadEnergy += cmdRdEnergy;
 
             /* Update IO_buffer/Memory's state */
-            if (traceType == TraceType::WR) {
+            if (traceT == TraceType::WR) {
+                unsigned int lineEncoded;
+                const DRAMdata &line = memory->read(cmd.add, lineEncoded);
                 for (fourbytes = 0; fourbytes < 16; fourbytes++) {
-                    cmd.data[fourbytes]       = memory[cmd.add.channel][cmd.add.rank][cmd.add.bank][cmd.add.row][cmd.add.col].data[fourbytes];
-                    IO_buffer.data[fourbytes] = memory[cmd.add.channel][cmd.add.rank][cmd.add.bank][cmd.add.row][cmd.add.col].data[fourbytes];
-                    encoded                   = memory[cmd.add.channel][cmd.add.rank][cmd.add.bank][cmd.add.row][cmd.add.col].encoded;
+                    cmd.data[fourbytes]       = line.data[fourbytes];
+                    IO_buffer.data[fourbytes] = line.data[fourbytes];
                 }
-            } else if (traceType == TraceType::RD_WR) {
+                encoded = lineEncoded;
+            } else if (traceT == TraceType::RD_WR) {
                 for (fourbytes = 0; fourbytes < 16; fourbytes++) {
                     IO_buffer.data[fourbytes] = cmd.data[fourbytes];
                 }
@@ -452,18 +618,17 @@ int Vampire::service_request(int encoded, Command cmd) {
             IO_buffer.prevAdd.bank = cmd.add.bank;
             IO_buffer.prevAdd.col = cmd.add.col;
 
-            dramStruct->banks->operator[](cmd.add.bank)->cmdEndTime = currentTime + cmdLengthInCycles(cmd.type);
+            bank.cmdEndTime = currentTime + cmdLengthInCycles(cmd.type);
             break;
         }
         case (int(CommandType::WR)): {
-            bool isBankClosed = dramStruct->bankStates->operator[](cmd.add.bank) != State::OPEN;
+            bool isBankClosed = dramStruct->bankStates[bankNum] != State::OPEN;
             msg::warning(isBankClosed, "WR/WRA called on closed bank");
 
-            /* Gets the # of set and toggle bits using the lambda corresponding to the current traceType */
-            auto numOfSetBits = getSetBits[int(traceType)](cmd.data);
-            auto numOfToggleBits = getToggleBits[int(traceType)](cmd.data, IO_buffer.data);
+            auto numOfSetBits = set_bits<traceT>(cmd.data);
+            auto numOfToggleBits = toggle_bits<traceT>(cmd.data, IO_buffer.data);
 
-            auto cmdWriteEnergy = equations->calc_rd_wr_energy(
+            auto cmdWriteEnergy = equations->calc_rd_wr_energy<vendorT>(
                     CommandType::WR,
                     cmd.add,
                     cmd.data,
@@ -474,20 +639,19 @@ int Vampire::service_request(int encoded, Command cmd) {
             ) - dramSpec->actStandbyEnergy * dramSpec->getCmdLength()[int(CommandType::WR)];
             cmdWriteEnergy /= 2; // Current model uses the standard IDD4 loops which have RD/WR energies of two command
 
-            if (structVar == StructVar::YES) {
-                totalWriteEnergy += cmdWriteEnergy * equations->struct_var_power_adjustment(CommandType::WR, cmd.add);
+            if (structVarT == StructVar::YES) {
+                totalWriteEnergy += cmdWriteEnergy * equations->struct_var_power_adjustment<vendorT>(CommandType::WR, cmd.add);
             } else {
                 totalWriteEnergy += cmdWriteEnergy;
             }
 
             /* Update Memory and buffer*/
-            if (traceType == TraceType::WR) {
+            if (traceT == TraceType::WR) {
+                memory->write(cmd.add, cmd.data, encoded);
                 for (fourbytes = 0; fourbytes < 16; fourbytes++) {
-                    memory[cmd.add.channel][cmd.add.rank][cmd.add.bank][cmd.add.row][cmd.add.col].data[fourbytes] = cmd.data[fourbytes];
-                    memory[cmd.add.channel][cmd.add.rank][cmd.add.bank][cmd.add.row][cmd.add.col].encoded = encoded;
                     IO_buffer.data[fourbytes] = cmd.data[fourbytes];
                 }
-            } else if (traceType == TraceType::RD_WR) {
+            } else if (traceT == TraceType::RD_WR) {
                 for (fourbytes = 0; fourbytes < 16; fourbytes++) {
                     IO_buffer.data[fourbytes] = cmd.data[fourbytes];
                 }
@@ -496,34 +660,34 @@ int Vampire::service_request(int encoded, Command cmd) {
             IO_buffer.prevAdd.bank = cmd.add.bank;
             IO_buffer.prevAdd.col = cmd.add.col;
 
-            dramStruct->banks->operator[](cmd.add.bank)->cmdEndTime = currentTime + cmdLengthInCycles(cmd.type);
+            bank.cmdEndTime = currentTime + cmdLengthInCycles(cmd.type);
 
             if (cmd.type == CommandType::WRA) {
-                dramStruct->bankStates->operator[](cmd.add.bank) =  State::CLOSE;
+                dramStruct->setBankState(bankNum, State::CLOSE);
             } else {
-                dramStruct->bankStates->operator[](cmd.add.bank) = State::OPEN;
+                dramStruct->setBankState(bankNum, State::OPEN);
             }
             break;
         }
         case (int(CommandType::ACT)):
-            dramStruct->bankStates->operator[](cmd.add.bank) = State::OPEN;
-            dramStruct->banks->operator[](cmd.add.bank)->cmdEndTime = this->currentTime + cmdLengthInCycles(cmd.type);
-            dramStruct->banks->operator[](cmd.add.bank)->actRowNum = cmd.add.row;
+            dramStruct->setBankState(bankNum, State::OPEN);
+            bank.cmdEndTime = this->currentTime + cmdLengthInCycles(cmd.type);
+            bank.actRowNum = cmd.add.row;
 
-            if (structVar == StructVar::NO) {
+            if (structVarT == StructVar::NO) {
                 totalActCmdEnergy += dramSpec->actCmdEnergy;
             } else {
 	            totalActCmdEnergy += dramSpec->actCmdEnergy;
             }
             break;
         case (int(CommandType::PRE)):
-            dramStruct->bankStates->operator[](cmd.add.bank) = State::CLOSE;
-            dramStruct->banks->operator[](cmd.add.bank)->cmdEndTime = this->currentTime + cmdLengthInCycles(cmd.type);
+            dramStruct->setBankState(bankNum, State::CLOSE);
+            bank.cmdEndTime = this->currentTime + cmdLengthInCycles(cmd.type);
 
             // Correct row address of the command since it isn't read from the trace for a PRE
-            cmd.add.row = dramStruct->banks->operator[](cmd.add.bank)->actRowNum;
+            cmd.add.row = bank.actRowNum;
 
-            if (structVar == StructVar::NO) {
+            if (structVarT == StructVar::NO) {
 	            totalPreCmdEnergy += dramSpec->preCmdEnergy;
             } else {
 	            totalPreCmdEnergy += dramSpec->preCmdEnergy;
@@ -545,7 +709,6 @@ int Vampire::service_request(int encoded, Command cmd) {
     statistics->cmdCycles->operator[]((uint64_t)(cmd.type)) += cmdLengthInCycles(cmd.type);
 
     dbgstream << ", cmdLengthInCycles: " << cmdLengthInCycles(cmd.type);
-    return 0;
 }
 
 /* Applies encoding to the data if it is read from the trace file */
@@ -597,33 +760,65 @@ void update_command_count(bool cond, Statistics &statistics, Command cmd) {
 }
 
 /* Gets commands from the trace file using parser->parse() and estimates their energy using service_request() */
-int Vampire::estimate(){
+template <TraceType traceT, VendorType vendorT, StructVar structVarT>
+void Vampire::estimate_commands() {
     int encoding = 0;
 
     /* Variables for passing data from parsers */
     Command cmd;
-    bool wasDataRead;
 
-    std::queue<Command> pendingQueue; // Queue to service the PRE commands generated by RDA/WRA
-    volatile bool parseSuccessful = parser->parse(wasDataRead, cmd);
+    // Commands before the window only warm up the state of the DRAM, the trace ends at the first command after it
+    bool isWindowed = windowStart > 0 || windowEnd != UINT64_MAX;
+    bool windowEnded = false;
+
+    // Commands are parsed in batches and handed out one at a time
+    std::vector<Command> batch(parseBatchSize);
+    size_t batchSize = 0, batchPos = 0;
+    auto next_command = [&] () -> bool {
+        while (batchPos == batchSize) {
+            batchSize = windowEnded ? 0 : parser->parse_batch(batch.data(), parseBatchSize);
+            batchPos = 0;
+            if (batchSize == 0)
+                return false;
+
+            if (isWindowed) {
+                while (batchPos < batchSize && batch[batchPos].issueTime < windowStart) {
+                    warm_up(batch[batchPos++]);
+                }
+                for (size_t pos = batchPos; pos < batchSize; pos++) {
+                    if (batch[pos].issueTime > windowEnd) {
+                        batchSize = pos;
+                        windowEnded = true;
+                        break;
+                    }
+                }
+            }
+            if (traceWriter != nullptr)
+                traceWriter->write(batch.data() + batchPos, batchSize - batchPos);
+        }
+        cmd = batch[batchPos++];
+        return true;
+    };
+
+    volatile bool parseSuccessful = next_command();
     update_command_count(parseSuccessful, *statistics, cmd);
 
-    while (parseSuccessful || pendingQueue.size() > 0){
+    while (parseSuccessful || (pendingQueue.size() > 0 && !keepPending)){
         // Check if the first pending command is ready to be serviced
         if (pendingQueue.size() > 0 ) {
             if (!(parseSuccessful) || (pendingQueue.front().issueTime <= cmd.issueTime)) {
-                auto &pendingCmd = pendingQueue.front();
+                auto pendingCmd = pendingQueue.front(); // Copied, pop() frees the element
                 pendingQueue.pop();
-                std::cout << std::endl << std::endl << std::endl << "Command issue time" << pendingCmd.issueTime << std::endl;
+                dbgstream << ", pending command issue time: " << pendingCmd.issueTime;
                 pendingCmd.finishTime = pendingCmd.issueTime + dramSpec->cmdLengthInCycles(pendingCmd.type);
-                service_request(0, pendingCmd);
+                service_request<traceT, vendorT, structVarT>(0, pendingCmd);
                 lastPendingCommandIssued = pendingCmd;
             }
             dbgstream << ", pending queue size: " << pendingQueue.size();
         }
 
         if (parseSuccessful) {
-            if ((wasDataRead) && (encodingType != EncodingType::NONE))
+            if ((cmd.hasData) && (encodingType != EncodingType::NONE))
                 apply_encoding(cmd.type, cmd.data, encoding);
 
             // Convert auto pre-charge commands to their open page counterparts and add the pre-charge to the pending queue
@@ -646,74 +841,443 @@ int Vampire::estimate(){
 
             dbgstream << cmd << ", length: " << dramSpec->cmdLengthInCycles(cmd.type) << std::endl;
 
-            service_request(0, cmd);
+            service_request<traceT, vendorT, structVarT>(0, cmd);
             cmd.add.reset();
-            parseSuccessful = parser->parse(wasDataRead, cmd);
+            parseSuccessful = next_command();
             update_command_count(parseSuccessful, *statistics, cmd);
             lastCommandIssued = cmd;
         }
     }
+}
+
+/* Instances of estimate_commands() for each trace type, vendor and structural variation */
+template <TraceType traceT, VendorType vendorT>
+Vampire::EstimateKernel Vampire::select_kernel(StructVar structVar) {
+    if (structVar == StructVar::YES)
+        return &Vampire::estimate_commands<traceT, vendorT, StructVar::YES>;
+    return &Vampire::estimate_commands<traceT, vendorT, StructVar::NO>;
+}
+
+template <TraceType traceT>
+Vampire::EstimateKernel Vampire::select_kernel(VendorType vendorType, StructVar structVar) {
+    switch (int(vendorType)) {
+        case (int(VendorType::A)):
+            return select_kernel<traceT, VendorType::A>(structVar);
+        case (int(VendorType::B)):
+            return select_kernel<traceT, VendorType::B>(structVar);
+        case (int(VendorType::C)):
+            return select_kernel<traceT, VendorType::C>(structVar);
+        default:
+            return select_kernel<traceT, VendorType::Cust>(structVar);
+    }
+}
 
-    dbgstream << "Last issued command: " << lastCommandIssued
-              << "lastStandbyEnergyEvalTime: " << lastStandbyEnergyEvalTime
-              << std::endl;
+Vampire::EstimateKernel Vampire::select_kernel() const {
+    switch (int(traceType)) {
+        case (int(TraceType::MEAN)):
+            return select_kernel<TraceType::MEAN>(vendorType, structVar);
+        case (int(TraceType::DIST)):
+            return select_kernel<TraceType::DIST>(vendorType, structVar);
+        case (int(TraceType::WR)):
+            return select_kernel<TraceType::WR>(vendorType, structVar);
+        default:
+            return select_kernel<TraceType::RD_WR>(vendorType, structVar);
+    }
+}
 
+uint64_t Vampire::close_ranks() {
     // Choose the finish time among last cmd and last pending to decide standby evaluation time
     uint64_t lastCmdFinishTime = std::max(lastCommandIssued.finishTime, lastPendingCommandIssued.finishTime);
 
-    if (lastStandbyEnergyEvalTime < lastCmdFinishTime) {
+    // The selected banks stand by until the last command of the trace (or window), even if it was not selected
+    uint64_t lastSkippedTime = std::min(parser->getSkippedUntil(), windowEnd);
+    lastCmdFinishTime = std::max(lastCmdFinishTime, lastSkippedTime);
+
+    // Every selected rank stands by until then, including the ones without any command
+    for (auto &rank : dramStruct->ranks) {
+        if (selection.matchesRank(rank.channel, rank.rank) && rank.lastStandbyEnergyEvalTime < lastCmdFinishTime)
+            add_standby_energy(rank, lastCmdFinishTime);
+    }
+
+    // Find the end time of the command which finished last among all the other commands
+    auto lastCmdEndTime = 0ul;
+    for (auto &bank : dramStruct->banks) {
+        lastCmdEndTime = lastCmdEndTime > bank.cmdEndTime ? lastCmdEndTime : bank.cmdEndTime;
+    }
+    return std::max<uint64_t>(lastCmdEndTime, lastSkippedTime);
+}
+
+Vampire *Vampire::new_partition(Parser *parser, const Selection &selection, unsigned int seed) {
+    auto *partition = new Vampire();
+
+    partition->encodingType = encodingType;
+    partition->vendorType = vendorType;
+    partition->structVar = structVar;
+    partition->traceType = traceType;
+    partition->parserType = parserType;
+    partition->memImageType = memImageType;
+    partition->memLimit = memLimit;
+    partition->parseBatchSize = parseBatchSize;
+    partition->windowStart = windowStart;
+    partition->windowEnd = windowEnd;
+    partition->selection = selection;
+    memcpy(partition->encoding_table, encoding_table, sizeof(encoding_table));
+
+    partition->configs = configs;
+    partition->dramSpec = dramSpec;
+    partition->parser = parser;
+    partition->dist = new std::vector<int>(NUM_OF_BITS+1);
+    partition->IO_buffer.init_values();
+    partition->statistics = new Statistics(configs->structCount, nullptr);
+    partition->equations = new Equations(*partition->statistics, *dramSpec, *configs, partition->vendorType,
+                                         partition->traceType, structVar);
+    partition->dramStruct = new DramStruct(*configs);
+    for (auto &rank : partition->dramStruct->ranks) {
+        rank.lastStandbyEnergyEvalTime = windowStart;
+    }
 
-        auto &cmdLength             =  dramSpec->getCmdLength();
-        auto &cmdCurrent            =  dramSpec->getCmdCurrent();
-        auto &memClkSpeed           =  dramSpec->memClkSpeed;
+    // The distributions of the DIST model are copied rather than drawn again
+    if (traceType == TraceType::DIST) {
+        partition->numOfSetBits = new std::vector<unsigned short>(*numOfSetBits);
+        partition->numOfToggleBits = new std::vector<unsigned short>(*numOfToggleBits);
+        partition->random = Random(seed);
+    } else {
+        partition->init_structures[int(traceType)]();
+    }
+    return partition;
+}
 
-        auto &totalReadEnergy       = *statistics->totalReadEnergy;
-        auto &totalWriteEnergy      = *statistics->totalWriteEnergy;
-        auto &totalActCmdEnergy     = *statistics->totalActCmdEnergy;
-        auto &totalPreCmdEnergy     = *statistics->totalPreCmdEnergy;
-        auto &totalActiveEnergy     = *statistics->totalActiveStandbyEnergy;
-        auto &totalPrechargeEnergy  = *statistics->totalPrechargeStandbyEnergy;
+/* Deletes a partition of the trace, without the configuration and the DRAM specification it shares */
+static void delete_partition(Vampire *partition) {
+    partition->configs = nullptr;
+    partition->dramSpec = nullptr;
+    delete partition;
+}
 
-        auto &totalActStandbyCycles = *statistics->totalActStandbyCycles;
-        auto &totalPreStandbyCycles = *statistics->totalPreStandbyCycles;
+/* Each partition is estimated as if the trace only held its commands, like with -select */
+uint64_t Vampire::estimate_partitions() {
+    DemuxParser demux(*parser, parallelLevel, configs->structCount, windowEnd, parseBatchSize);
+    std::vector<Vampire *> partitions;
+    std::vector<std::thread> threads;
+
+    for (size_t pos = 0; pos < demux.partitionCount(); pos++) {
+        Selection partSelection = selection;
+        if (parallelLevel == Level::RANK) {
+            partSelection.narrow(Level::CHANNEL, pos / configs->getNumRanks());
+            partSelection.narrow(Level::RANK, pos % configs->getNumRanks());
+        } else {
+            partSelection.narrow(Level::CHANNEL, pos);
+        }
+        partitions.push_back(new_partition(demux.partition(pos), partSelection, (unsigned int) pos + 1));
+    }
+
+    msg::info("Estimating " + std::to_string(partitions.size()) + " partitions of the trace on their own threads");
+    for (auto *partition : partitions) {
+        threads.emplace_back([partition] {(partition->*partition->select_kernel())();});
+    }
+
+    uint64_t lastCmdEndTime = 0;
+    for (size_t pos = 0; pos < partitions.size(); pos++) {
+        threads[pos].join();
+        lastCmdEndTime = std::max(lastCmdEndTime, partitions[pos]->close_ranks());
+        statistics->merge(*partitions[pos]->statistics);
+        if (traceType == TraceType::WR)
+            partitions[pos]->memory->print_stats();
+
+        // The parser of the partition belongs to the demultiplexer
+        partitions[pos]->parser = nullptr;
+        delete_partition(partitions[pos]);
+    }
+    return lastCmdEndTime;
+}
 
-        auto &vdd                   = dramSpec->vdd;
+TraceIndex *Vampire::load_segment_index() {
+    // The memory image of the WR model needs every write before a segment, which only the segment before knows
+    if (traceType == TraceType::WR) {
+        msg::info("The WR model cannot be estimated in segments, the trace is estimated in one piece.");
+        return nullptr;
+    }
 
-        bool allBankPrecharged = true;
+    // Only plain trace files are indexed, the segments read the trace with parsers of their own
+    TraceIndex *index = TraceIndex::load(*traceFilename, parserType, traceType);
+    msg::warning(index == nullptr, "Segments start at the checkpoints of the index of the trace, which has none (see "
+                                   "-buildIndex), the trace is estimated in one piece.");
+    return index;
+}
 
-        // Check DRAM's state for bg energy calculation
-        auto timeDiff = lastCmdFinishTime - lastStandbyEnergyEvalTime;
-        for (uint64_t i = 0; i < dramStruct->banks->size(); i++) {
-            auto &bank = dramStruct->banks->operator[](i);
-            auto &bankState = dramStruct->bankStates->operator[](i);
+Parser *Vampire::new_segment_parser(const TraceCheckpoint *checkpoint, uint64_t count) {
+    Parser *source = new_parser();
+    source->setDirectIO(directIO);
+    source->setFilename(*traceFilename);
+    source->setTraceType(traceType);
 
-            if (timeDiff && dramStruct->bankStates->operator[](i) == State::OPEN)
-                allBankPrecharged = false;
+    if (checkpoint != nullptr && !source->seek(checkpoint->offset, checkpoint_command(*checkpoint))) {
+        msg::error("Unable to seek the trace to the checkpoint at command #" + std::to_string(checkpoint->commandIndex)
+                   + ".");
+    }
+    return new SegmentParser(source, count);
+}
+
+bool Vampire::reaches(const TraceIndex &index, const TraceCheckpoint &checkpoint) const {
+    if (!pendingQueue.empty() || IO_buffer.prevAdd.bank != checkpoint.ioBank || IO_buffer.prevAdd.col != checkpoint.ioCol)
+        return false;
+    if (traceType == TraceType::RD_WR && memcmp(IO_buffer.data, checkpoint.ioData, sizeof(IO_buffer.data)) != 0)
+        return false;
+
+    // Banks without a state at the checkpoint are closed
+    std::vector<State> states(dramStruct->bankStates.size(), State::CLOSE);
+    std::vector<uint64_t> rows(dramStruct->banks.size(), 0);
+    const TraceBankState *banks = index.banks(checkpoint);
+    for (uint64_t pos = 0; pos < index.header.bankCount; pos++) {
+        MappedAdd add(banks[pos].channel, banks[pos].rank, banks[pos].bank, 0, 0);
+        if (add.channel >= configs->getNumChannels() || add.rank >= configs->getNumRanks()
+            || add.bank >= configs->getNumBanks())
+            continue;
+
+        states[dramStruct->bankIndex(add)] = banks[pos].open ? State::OPEN : State::CLOSE;
+        rows[dramStruct->bankIndex(add)] = banks[pos].actRowNum;
+    }
+
+    for (uint64_t bank = 0; bank < states.size(); bank++) {
+        if (dramStruct->bankStates[bank] != states[bank]
+            || (states[bank] == State::OPEN && dramStruct->banks[bank].actRowNum != rows[bank]))
+            return false;
+    }
+    return true;
+}
+
+void Vampire::continue_from(const Vampire &previous) {
+    dramStruct->banks = previous.dramStruct->banks;
+    dramStruct->bankStates = previous.dramStruct->bankStates;
+    dramStruct->ranks = previous.dramStruct->ranks;
+    IO_buffer = previous.IO_buffer;
+    pendingQueue = previous.pendingQueue;
+    lastCommandIssued = previous.lastCommandIssued;
+    lastPendingCommandIssued = previous.lastPendingCommandIssued;
+    random = previous.random;
+}
+
+/*
+ * Each segment starts from the state of the DRAM at its checkpoint, where the segment before is expected to leave it.
+ * The standby of each rank up to its first command is only known once the segment before is estimated, and a segment
+ * whose start does not match the end of the one before (e.g. because of an auto-precharge still pending) is estimated
+ * again from there. The MEAN and RD_WR models thus add up to the estimate of the whole trace.
+ */
+uint64_t Vampire::estimate_segments(const TraceIndex &index) {
+    // Segments start at the last checkpoint before each even share of the commands, nullptr is the start of the trace
+    std::vector<const TraceCheckpoint *> starts = {nullptr};
+    for (size_t segment = 1; segment < segments; segment++) {
+        uint64_t share = index.header.commandCount * segment / segments;
+        const TraceCheckpoint *start = nullptr;
+        for (auto &checkpoint : index.checkpoints) {
+            if (checkpoint.commandIndex > 0 && checkpoint.commandIndex <= share)
+                start = &checkpoint;
+        }
+        if (start != nullptr && (starts.back() == nullptr || start->commandIndex > starts.back()->commandIndex))
+            starts.push_back(start);
+    }
+
+    auto new_segment = [&] (size_t pos) -> Vampire * {
+        uint64_t first = starts[pos] == nullptr ? 0 : starts[pos]->commandIndex;
+        uint64_t count = pos + 1 < starts.size() ? starts[pos + 1]->commandIndex - first : UINT64_MAX;
+        Vampire *segment = new_partition(new_segment_parser(starts[pos], count), selection, (unsigned int) pos + 1);
+        segment->keepPending = pos + 1 < starts.size();
+        return segment;
+    };
+
+    std::vector<Vampire *> parts;
+    for (size_t pos = 0; pos < starts.size(); pos++) {
+        parts.push_back(new_segment(pos));
+        if (starts[pos] != nullptr) {
+            parts[pos]->restore_checkpoint(index, *starts[pos]);
+            for (auto &rank : parts[pos]->dramStruct->ranks) {
+                rank.lastStandbyEnergyEvalTime = DramStruct::Rank::DEFERRED;
+            }
         }
+    }
+
+    msg::info("Estimating " + std::to_string(parts.size()) + " segments of the trace on their own threads");
+    std::vector<std::thread> threads;
+    for (auto *part : parts) {
+        threads.emplace_back([part] {(part->*part->select_kernel())();});
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
 
-        dbgstream << "currentTime: " << currentTime << std::endl;
-        dbgstream << "timeDiff: " << timeDiff << std::endl;
+    for (size_t pos = 1; pos < parts.size(); pos++) {
+        Vampire &previous = *parts[pos - 1];
+        if (!previous.reaches(index, *starts[pos])) {
+            msg::info("Segment #" + std::to_string(pos) + " does not start where the one before ends, it is estimated "
+                      "again from there.");
+            delete_partition(parts[pos]);
+            parts[pos] = new_segment(pos);
+            parts[pos]->continue_from(previous);
+            (parts[pos]->*parts[pos]->select_kernel())();
+            continue;
+        }
+
+        // Each rank stands by from its last command in the segments before to its first command in this one
+        for (size_t rank = 0; rank < parts[pos]->dramStruct->ranks.size(); rank++) {
+            DramStruct::Rank &first = parts[pos]->dramStruct->ranks[rank];
+            DramStruct::Rank last = previous.dramStruct->ranks[rank];
+            if (first.lastStandbyEnergyEvalTime == DramStruct::Rank::DEFERRED) {
+                first.lastStandbyEnergyEvalTime = last.lastStandbyEnergyEvalTime;
+            } else {
+                parts[pos]->add_standby_energy(last, first.firstStandbyEvalTime);
+            }
+        }
+        if (parts[pos]->lastCommandIssued.finishTime < previous.lastCommandIssued.finishTime)
+            parts[pos]->lastCommandIssued = previous.lastCommandIssued;
+        if (parts[pos]->lastPendingCommandIssued.finishTime < previous.lastPendingCommandIssued.finishTime)
+            parts[pos]->lastPendingCommandIssued = previous.lastPendingCommandIssued;
+    }
+
+    uint64_t lastCmdEndTime = parts.back()->close_ranks();
+    for (auto *part : parts) {
+        for (auto &bank : part->dramStruct->banks) {
+            lastCmdEndTime = std::max(lastCmdEndTime, bank.cmdEndTime);
+        }
+        statistics->merge(*part->statistics);
+        delete_partition(part);
+    }
+    return lastCmdEndTime;
+}
+
+SweepConfig SweepConfig::parse(const std::string &config) {
+    SweepConfig sweepConfig;
+    std::vector<std::string> fields;
+    std::stringstream ss(config);
+    std::string field;
+    while (std::getline(ss, field, ':')) {
+        fields.push_back(field);
+    }
 
-        // Add corresponding background energy to the stats
-        if (allBankPrecharged) {
-            totalPrechargeEnergy += timeDiff*dramSpec->preStandbyEnergy;
-            totalPreStandbyCycles += timeDiff;
+    auto vendor = std::find(vendorString, vendorString + int(VendorType::MAX), fields.empty() ? "" : fields[0]);
+    if (vendor == vendorString + int(VendorType::MAX)) {
+        msg::error("Configuration `" + config + "' of the sweep does not start with a vendor, see vampire --help for "
+                   "more details.");
+    }
+    sweepConfig.vendorType = (VendorType) (vendor - vendorString);
+
+    for (size_t pos = 1; pos < fields.size(); pos++) {
+        if (fields[pos] == "s") {
+            sweepConfig.structVar = StructVar::YES;
+        } else if (sweepConfig.vendorType == VendorType::Cust && sweepConfig.dramSpecFilename.empty()) {
+            sweepConfig.dramSpecFilename = fields[pos];
         } else {
-            totalActiveEnergy += timeDiff*dramSpec->actStandbyEnergy;
-            totalActStandbyCycles += timeDiff;
+            msg::error("Unexpected `" + fields[pos] + "' in configuration `" + config + "' of the sweep, see vampire "
+                       "--help for more details.");
         }
+    }
+    if (sweepConfig.vendorType == VendorType::Cust && sweepConfig.dramSpecFilename.empty()) {
+        msg::error("No dramSpec file specified with Cust Vender in configuration `" + config + "' of the sweep.");
+    }
+    return sweepConfig;
+}
+
+std::string SweepConfig::toString() const {
+    return vendorString[int(vendorType)] + (dramSpecFilename.empty() ? "" : ":" + dramSpecFilename)
+           + (structVar == StructVar::YES ? ":s" : "");
+}
+
+/* The CSV of each configuration is named after its position in the sweep, e.g. stats.csv becomes stats.0.csv */
+static std::string sweep_csv_filename(const std::string &csvFilename, size_t pos) {
+    size_t extension = csvFilename.rfind('.');
+    if (extension == std::string::npos || csvFilename.find('/', extension) != std::string::npos)
+        return csvFilename + "." + std::to_string(pos);
+    return csvFilename.substr(0, extension) + "." + std::to_string(pos) + csvFilename.substr(extension);
+}
 
+/*
+ * The timing of the commands depends on the DRAM specification, so each configuration keeps its own state of the DRAM
+ * and only the parsing of the trace is shared. With the DIST model, every configuration draws the random sequence of a
+ * run of its own.
+ */
+void Vampire::estimate_sweep() {
+    DemuxParser broadcast(*parser, sweep.size(), windowEnd, parseBatchSize);
+    std::vector<Vampire *> estimators;
+    std::vector<std::thread> threads;
+
+    for (size_t pos = 0; pos < sweep.size(); pos++) {
+        Vampire *estimator = new_partition(broadcast.partition(pos), selection, 1);
+        // The state restored from the trace index before the window, if any, and the seed of a run of its own
+        estimator->continue_from(*this);
+
+        estimator->vendorType = sweep[pos].vendorType;
+        estimator->structVar = sweep[pos].structVar;
+        estimator->dramSpec = new_dram_spec(sweep[pos].vendorType, &sweep[pos].dramSpecFilename);
+        delete estimator->equations;
+        estimator->equations = new Equations(*estimator->statistics, *estimator->dramSpec, *configs,
+                                             estimator->vendorType, traceType, estimator->structVar);
+        estimators.push_back(estimator);
     }
-    // Find the end time of the command which finished last among all the other commands
-    auto lastCmdEndTime = 0ul;
-    for (auto bank : *dramStruct->banks) {
-        lastCmdEndTime = lastCmdEndTime > bank->cmdEndTime ? lastCmdEndTime : bank->cmdEndTime;
+
+    msg::info("Estimating " + std::to_string(estimators.size()) + " configurations in one pass over the trace");
+    for (auto *estimator : estimators) {
+        threads.emplace_back([estimator] {(estimator->*estimator->select_kernel())();});
     }
 
-    statistics->calculateTotal(*dramSpec, lastCmdEndTime);
+    for (size_t pos = 0; pos < estimators.size(); pos++) {
+        Vampire &estimator = *estimators[pos];
+        threads[pos].join();
+        uint64_t lastCmdEndTime = estimator.close_ranks();
+        estimator.statistics->calculateTotal(*estimator.dramSpec,
+                                             lastCmdEndTime > windowStart ? lastCmdEndTime - windowStart : 0);
+
+        msg::info("Configuration #" + std::to_string(pos) + ": " + sweep[pos].toString());
+        estimator.statistics->print_stats();
+        if (traceType == TraceType::WR)
+            estimator.memory->print_stats();
+
+        if (csvFilename != nullptr) {
+            std::string sweepCsvFilename = sweep_csv_filename(*csvFilename, pos);
+            estimator.statistics->write_csv(&sweepCsvFilename);
+        }
+
+        // Unlike the configuration, the DRAM specification belongs to the estimator, its parser to the broadcast
+        DramSpec *sweepDramSpec = estimator.dramSpec;
+        estimator.parser = nullptr;
+        delete_partition(estimators[pos]);
+        delete sweepDramSpec;
+    }
+}
+
+int Vampire::estimate(){
+    uint64_t lastCmdEndTime;
+
+    if (!sweep.empty()) {
+        estimate_sweep();
+        return 0;
+    }
+
+    TraceIndex *index = segments > 1 ? load_segment_index() : nullptr;
+
+    if (parallelLevel != Level::MAX) {
+        lastCmdEndTime = estimate_partitions();
+    } else if (index != nullptr) {
+        lastCmdEndTime = estimate_segments(*index);
+        delete index;
+    } else {
+        (this->*select_kernel())();
+        dbgstream << "Last issued command: " << lastCommandIssued << std::endl;
+        lastCmdEndTime = close_ranks();
+    }
+
+    if (traceWriter != nullptr)
+        traceWriter->close();
+
+    statistics->calculateTotal(*dramSpec, lastCmdEndTime > windowStart ? lastCmdEndTime - windowStart : 0);
 
     statistics->print_stats();
 
+    if (traceType == TraceType::WR && parallelLevel == Level::MAX) {
+        memory->print_stats();
+
+        if (memImageOutFilename != nullptr)
+            memory->dump(*memImageOutFilename);
+    }
+
     if (this->csvFilename != nullptr) {
         statistics->write_csv(csvFilename);
     }
@@ -726,6 +1290,8 @@ void Vampire::free_memory() {
     // Call to lambda for freeing TraceType specific allocations
     free_structures[int(traceType)]();
 
+    delete parser;
+
     // Free rest of the allocated variables
     free(configs);
 }
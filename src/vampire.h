@@ -20,6 +20,7 @@ Released under the MIT License
 #include <functional>
 #include <iostream>
 #include <iomanip>
+#include <queue>
 #include <vector>
 
 #include "sysexits.h"
@@ -30,11 +31,24 @@ Released under the MIT License
 #include "dramStruct.h"
 #include "equations.h"
 #include "helper.h"
+#include "memoryImage.h"
 #include "parser.h"
+#include "importParser.h"
 #include "statistics.h"
 #include "command.h"
 #include "globalDebug.h"
 
+/* Vendor, DRAM specification and structural variation of a configuration of a sweep (see Vampire::sweep) */
+struct SweepConfig {
+    VendorType vendorType = VendorType::A;
+    std::string dramSpecFilename;           // Only used by VendorType::Cust
+    StructVar structVar = StructVar::NO;
+
+    /* Parses <vendor>[:<dramSpec_file>][:s] */
+    static SweepConfig parse(const std::string &config);
+    std::string toString() const;
+};
+
 class Vampire {
 
 public:
@@ -45,16 +59,39 @@ public:
     VendorType     vendorType;        /* OPTIONS ARE A, B, C */
     StructVar      structVar;         /* OPTIONS ARE NO, YES */
     TraceType      traceType;         /* OPTIONS ARE RATIO, DIST, WR, RD_WR */
-    ParserType     parserType;        /* OPTIONS ARE BINARY, ASCII*/
+    ParserType     parserType;        /* OPTIONS ARE BINARY, ASCII, RAMULATOR, DRAMSIM3, DRAMPOWER*/
+    MemImageType   memImageType;      /* OPTIONS ARE SPARSE, FLAT, DEDUP, COMPRESSED */
 
     std::string *traceFilename = nullptr;
     std::string *configFilename = nullptr;
 
     std::string *dramSpecFilename = nullptr;
     std::string *csvFilename = nullptr;
+    std::string *memImageInFilename = nullptr;
+    std::string *memImageOutFilename = nullptr;
+    std::string *traceOutFilename = nullptr;
+    uint64_t memLimit = 0;                  // Bound on the RAM holding rows of the memory image, 0 if unbounded
+    size_t parseDepth = 0;                  // # of batches decoded ahead by a parsing thread, 0 parses inline
+    size_t parseBatchSize = PARSE_BATCH_SIZE;
+    size_t parseThreads = 0;                // # of threads parsing chunks of an ASCII trace, 0 parses sequentially
+    uint64_t windowStart = 0;               // Only the commands issued in [windowStart, windowEnd] are estimated
+    uint64_t windowEnd = UINT64_MAX;
+    bool buildIndex = false;                // Indexes the trace (and traceOutFilename) for seeking to windowStart
+    uint64_t indexInterval = TRACE_INDEX_INTERVAL;
+    bool follow = false;                    // Waits for more commands at the end of the trace, until its end-of-input marker
+    unsigned int followTimeout = 0;         // ms without new commands after which a followed trace ends, 0 waits forever
+    bool directIO = false;                  // Reads the trace around the page cache
+    Selection selection;                    // Subset of the commands to estimate, its time range narrows the window
+    Level parallelLevel = Level::MAX;       // Estimates each channel (CHANNEL) or rank (RANK) on its own thread, the
+                                            // whole trace on this one if MAX
+    size_t segments = 0;                    // # of time segments of the trace estimated side by side from the
+                                            // checkpoints of its index, 0 or 1 estimates it in one piece
+    std::vector<SweepConfig> sweep;         // Configurations estimated in the same pass over the trace instead of the
+                                            // vendor, DRAM specification and structural variation of this one
 
     Config *configs;
     Parser *parser;
+    TraceWriter *traceWriter = nullptr;     // Copies the commands of the trace to traceOutFilename, if set
     DramSpec *dramSpec = nullptr;
 
     DramStruct *dramStruct;                         // Stores the state of different elements of a DRAM
@@ -63,7 +100,6 @@ public:
     Command lastCommandIssued;
     Command lastPendingCommandIssued;
 
-    uint64_t lastStandbyEnergyEvalTime = 0ul; // Keeps track of the time when the last standby time evaluation took place
 protected:
     /* Constants */
     const int NUM_OF_SET_BIT_ARR_MULT = 1000; // (NUM_OF_BITS) X this_variable is size of the array used for
@@ -78,16 +114,81 @@ protected:
     void init_lambdas();
     void init_latencies();
 
+    /* Creates a sequential parser of parserType */
+    Parser *new_parser() const;
+    /* Creates the DRAM specification of vendorType, read from dramSpecFilename for VendorType::Cust */
+    DramSpec *new_dram_spec(VendorType vendorType, const std::string *dramSpecFilename) const;
+    /* Scans the trace with a new parser and writes its index */
+    void build_index();
+    /* Moves the parser to the last checkpoint of the trace index before windowStart and restores the DRAM state */
+    void seek_window();
+    /* Restores the state of the banks and of the IO buffer at checkpoint of index */
+    void restore_checkpoint(const TraceIndex &index, const TraceCheckpoint &checkpoint);
+    /* Applies a command before windowStart to the state of the DRAM without estimating its energy */
+    void warm_up(Command &cmd);
+    /* Adds the standby energy of rank up to time, in active standby if any of its banks is open */
+    void add_standby_energy(DramStruct::Rank &rank, uint64_t time);
+    /* Adds the standby energy of the selected ranks up to the end of the trace, returns the end time of its last
+     * command */
+    uint64_t close_ranks();
+
+    /* Creates the estimator of a partition of the trace, which reads its commands from parser and only closes the ranks
+     * of selection. It shares the configuration and the DRAM specification, which are only read while estimating */
+    Vampire *new_partition(Parser *parser, const Selection &selection, unsigned int seed);
+    /* Estimates each partition of the trace (see parallelLevel) on its own thread and merges their statistics, returns
+     * the end time of the last command */
+    uint64_t estimate_partitions();
+
+    /* Loads the index whose checkpoints the trace is split at into segments, nullptr if it cannot be split */
+    TraceIndex *load_segment_index();
+    /* Creates a parser of the next count commands of the trace after checkpoint, or from its start if nullptr */
+    Parser *new_segment_parser(const TraceCheckpoint *checkpoint, uint64_t count);
+    /* Whether the DRAM is left in the state restored from checkpoint of index, with no auto-precharge pending */
+    bool reaches(const TraceIndex &index, const TraceCheckpoint &checkpoint) const;
+    /* Continues the estimation from the state of the DRAM at the end of previous */
+    void continue_from(const Vampire &previous);
+    /* Estimates segments of the trace (see segments) on their own threads, reconciles their boundaries in order and
+     * merges their statistics, returns the end time of the last command */
+    uint64_t estimate_segments(const TraceIndex &index);
+
+    /* Estimates each configuration of sweep on its own thread from the commands of a single parser, then prints and
+     * writes the statistics of each of them */
+    void estimate_sweep();
+
+    // The DIST model draws its data from a random sequence of its own, the one of rand() in a run of its own, so that
+    // a configuration of a sweep draws as such a run would. Partitions estimated side by side are seeded apart
+    Random random;
+    int draw_random() {return random.next();}
+
     /* Stores latency of each operation */
     //std::vector<float> latency[int(VendorType::MAX)];
 
     /* Calculates # of set bits in data */
-    std::function<unsigned int(unsigned int[16])> getSetBits[int(TraceType::MAX)];
+    template <TraceType traceT>
+    unsigned int set_bits(unsigned int data[16]);
     /* Calculates # of bits toggled between old_data and new_data */
-    std::function<unsigned int(unsigned int[16], unsigned int[16])> getToggleBits[int(TraceType::MAX)];
+    template <TraceType traceT>
+    unsigned int toggle_bits(unsigned int new_data[16], unsigned int old_data[16]);
+
+    /*
+     * The estimation loop and the energy of each command are specialized for the trace type, vendor and structural
+     * variation, estimate() picks the instance of the current ones before going through the trace.
+     */
+    using EstimateKernel = void (Vampire::*)();
+    template <TraceType traceT, VendorType vendorT, StructVar structVarT>
+    void estimate_commands();
+    template <TraceType traceT, VendorType vendorT, StructVar structVarT>
+    void service_request(int encoded, Command cmd);
+    template <TraceType traceT, VendorType vendorT>
+    static EstimateKernel select_kernel(StructVar structVar);
+    template <TraceType traceT>
+    static EstimateKernel select_kernel(VendorType vendorType, StructVar structVar);
+    EstimateKernel select_kernel() const;
 
     IO_data IO_buffer;
-    DRAMdata ***** memory;
+    std::queue<Command> pendingQueue;       // PREs of the RDA/WRA serviced so far, issued once the trace reaches them
+    bool keepPending = false;               // Leaves the PREs still pending at the end to the next segment of the trace
+    MemoryImage *memory = nullptr;          // Contents of the DRAM, only used by TraceType::WR
 
     /*** Variables for TraceType::DIST ***/
     std::vector<unsigned short> *numOfSetBits;    // Array for finding number of set btis in case
@@ -102,7 +203,6 @@ public:
     std::vector<int> *dist;
 
     int set_values                      ();
-    int service_request(int encoded, Command cmd);
     void free_memory                    (void);
     void apply_encoding                 (CommandType &req, unsigned int *data, int &encoding);
     int  estimate                       (void);
@@ -6,7 +6,9 @@
 # Copyright (c) SAFARI Research Group at Carnegie Mellon University and ETH Zurich
 # Released under the MIT License
 
+import gzip
 import os.path
+import re
 import subprocess
 import csv
 import sys
@@ -15,6 +17,9 @@ SCRIPT_DIR = ""
 VAMPIRE_DIR = ""
 VAMPIRE_CFG = ""
 
+DRAMSIM3_BANKS_PER_GROUP = 4
+DRAMSIM3_NAMES = {"ACT": "activate", "PRE": "precharge", "RD": "read", "WR": "write", "RDA": "read_p", "WRA": "write_p"}
+
 def exec_shell(cmd, get_output=False, stdout="/dev/null"):
     if (get_output):
         try:
@@ -26,7 +31,7 @@ def exec_shell(cmd, get_output=False, stdout="/dev/null"):
         return (returncode, "")
 
 
-def vampire(trace_f, config="", vendor="A", csv_f="", data_model="RD_WR", parser="ASCII", dramSpec=None):
+def vampire(trace_f, config="", vendor="A", csv_f="", data_model="RD_WR", parser="ASCII", dramSpec=None, extra_args=""):
     if config == "":
         config = VAMPIRE_CFG
 
@@ -39,7 +44,10 @@ def vampire(trace_f, config="", vendor="A", csv_f="", data_model="RD_WR", parser
 
     if not dramSpec == None:
         vampire_cmd += " -dramSpec %s" % dramSpec
-    exec_shell(vampire_cmd)
+    if not extra_args == "":
+        vampire_cmd += " " + extra_args
+    (returncode, _) = exec_shell(vampire_cmd)
+    return returncode
 
 def convert_trace(in_f, out_f, data_model):
     trace_conv_cmd = "%s/tests/vampireAsciiToBin.py -i %s -o %s -d %s" \
@@ -60,17 +68,54 @@ def setup():
 
 # Raises exception if every csv in the csv_arr is not identical to others else returns True
 def compare_csv(csv_arr):
-    first_csv = csv_arr[1]
+    first_csv = csv_arr[0]
     first_csv_rows = [row for row in first_csv]
 
     for csv in csv_arr[1:]:
-        row_iter = 0
-        for row in csv:
-            if not first_csv_rows[row_iter] == row:
-                raise ValueError("CSV match failed")
-            row_iter += 1
+        if not [row for row in csv] == first_csv_rows:
+            raise ValueError("CSV match failed")
     return True
 
+# Returns the value of each stat of a csv written by VAMPIRE
+def read_csv(csv_f):
+    return dict((row[0], row[1]) for row in list(csv.reader(open(csv_f), delimiter=','))[1:])
+
+# Writes the default config with the given values, e.g. write_config(config_f, numChannels=2, numRanks=2)
+def write_config(config_f, **values):
+    config = open(VAMPIRE_CFG).read()
+    for key, value in values.items():
+        config = re.sub(r"(?m)^%s = \d+" % key, "%s = %d" % (key, value), config)
+    open(config_f, "w").write(config)
+
+# Converts the commands of an ASCII trace to (time, line) pairs of a DRAMSim3 command trace of the given channel and rank,
+# as DRAMSim3 traces hold the channel and rank of each command. The commands can be delayed and moved to other banks
+def to_dramsim3(cmds, channel=0, rank=0, time_shift=0, bank_shift=0):
+    lines = []
+    for cmd in cmds:
+        time = int(cmd[0]) + time_shift
+        bank = (int(cmd[2]) + bank_shift) % 8
+        row = int(cmd[3]) if cmd[1] == "ACT" else 0
+        col = int(cmd[3]) if cmd[1] != "ACT" and len(cmd) > 3 else 0
+        lines.append((time, "%-10s %-18s %d %d %d %d %s %s"
+                      % (time, DRAMSIM3_NAMES[cmd[1]], channel, rank, bank / DRAMSIM3_BANKS_PER_GROUP,
+                         bank % DRAMSIM3_BANKS_PER_GROUP, hex(row), hex(col))))
+    return lines
+
+def write_trace(trace_f, lines):
+    open(trace_f, "w").write("\n".join(lines) + "\n")
+
+# Gzip compressed copy of a trace, which must not end with `.trace' or run_tests.sh would archive it
+def compress_gzip(trace_f):
+    out_f = trace_f + ".gz"
+    with open(trace_f, "rb") as src:
+        with gzip.open(out_f, "wb") as dst:
+            dst.write(src.read())
+    return out_f
+
+# Lines of (time, line) pairs in the order of their time
+def by_time(lines):
+    return [line for _, line in sorted(lines, key=lambda line: line[0])]
+
 def check_for_nan(csv_arr):
     for csv in csv_arr:
         row_iter = 0
@@ -44,9 +44,10 @@ def test_autoprecharge():
                 
             temp_result_f.append(csv_f)
 
-        # Compare csv files
+        # Compare csv files, an auto-precharge is counted as a RDA/WRA rather than as a RD/WR and a PRE
         try:
-            hp.compare_csv([csv.reader(open(f), delimiter=',') for f in temp_result_f])
+            hp.compare_csv([[row for row in csv.reader(open(f), delimiter=',') if not row[0].endswith(" count")]
+                            for f in temp_result_f])
         except ValueError:
             print "Comparison failed"
             tests_status[test_pair_id] = 1
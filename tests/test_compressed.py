@@ -0,0 +1,98 @@
+#!/usr/bin/env python2
+
+# test_compressed.py
+
+# VAMPIRE: Variation-Aware model of Memory Power Informed by Real Experiments
+# https://github.com/CMU-SAFARI/VAMPIRE
+
+# Copyright (c) SAFARI Research Group at Carnegie Mellon University and ETH Zurich
+# Released under the MIT License
+
+import csv
+import glob
+import os
+import subprocess
+import tarfile
+from distutils.spawn import find_executable
+import helper as hp
+
+# Compressed copies of a trace, none of them may end with `.trace' or run_tests.sh would archive them
+def compress_tar(trace_f):
+    out_f = trace_f + ".tar"
+    with tarfile.open(out_f, "w") as tar:
+        tar.add(trace_f, arcname=os.path.basename(trace_f))
+    return out_f
+
+def compress_tgz(trace_f):
+    out_f = trace_f + ".tgz"
+    with tarfile.open(out_f, "w:gz") as tar:
+        tar.add(trace_f, arcname=os.path.basename(trace_f))
+    return out_f
+
+def compress_tool(tool, extension):
+    def compress(trace_f):
+        out_f = trace_f + extension
+        subprocess.check_call([tool, "-q", "-f", "-k", "-c", trace_f], stdout=open(out_f, "wb"))
+        return out_f
+    return compress
+
+# Formats whose decompressor is missing from this build of VAMPIRE are skipped, the others must match the plain trace
+COMPRESSORS = [("gzip", hp.compress_gzip), ("tar", compress_tar), ("tar.gz", compress_tgz)]
+for tool, extension in [("xz", ".xz"), ("zstd", ".zst")]:
+    if find_executable(tool) is not None:
+        COMPRESSORS.append((tool, compress_tool(tool, extension)))
+
+def is_supported(compressed_f):
+    output = subprocess.Popen([hp.VAMPIRE_PATH, "-f", compressed_f, "-c", hp.VAMPIRE_CFG, "-d", "MEAN", "-p", "ASCII"],
+                              stdout=subprocess.PIPE, stderr=subprocess.STDOUT).communicate()[0]
+    return "was built without" not in output
+
+def test_compressed(trace_f, data_model, parser):
+    tests_status = []
+    plain_csv = trace_f + ".plain.csv"
+    hp.vampire(trace_f, csv_f=plain_csv, data_model=data_model, parser=parser)
+
+    for name, compress in COMPRESSORS:
+        compressed_f = compress(trace_f)
+        csv_f = compressed_f + ".csv"
+        status = 0
+
+        if not is_supported(compressed_f):
+            print "[test_compressed]: Skipping " + name + ", not supported by this build"
+        else:
+            if hp.vampire(compressed_f, csv_f=csv_f, data_model=data_model, parser=parser) != 0:
+                status = 1
+            try:
+                hp.compare_csv([csv.reader(open(f), delimiter=',') for f in [plain_csv, csv_f]])
+            except (ValueError, IOError):
+                status = 1
+            print "[test_compressed]: Test " + os.path.basename(trace_f) + " " + parser + " " + name + " " \
+                  + ["passed", "failed"][status]
+            tests_status.append(status)
+
+        for f in [compressed_f, csv_f]:
+            if os.path.isfile(f):
+                os.remove(f)
+
+    os.remove(plain_csv)
+    return tests_status
+
+def main():
+    hp.setup()
+    tests_status = []
+
+    for trace_f in sorted(glob.glob(hp.VAMPIRE_DIR + "/tests/traces/parser/0-*.trace")):
+        data_model = os.path.basename(trace_f).split("-")[1].split(".")[0].upper()
+        bin_f = trace_f + ".bin"
+        hp.convert_trace(trace_f, bin_f, data_model=data_model)
+
+        tests_status += test_compressed(trace_f, data_model, "ASCII")
+        tests_status += test_compressed(bin_f, data_model, "BINARY")
+        os.remove(bin_f)
+
+    pass_count = tests_status.count(0)
+    print "[test_compressed]: %d test completed, %d%% passed" \
+          % (len(tests_status), pass_count * 100 / max(len(tests_status), 1))
+    return 0 if pass_count == len(tests_status) else 1
+
+exit(main())
@@ -0,0 +1,61 @@
+#!/usr/bin/env python2
+
+# test_direct_io.py
+
+# VAMPIRE: Variation-Aware model of Memory Power Informed by Real Experiments
+# https://github.com/CMU-SAFARI/VAMPIRE
+
+# Copyright (c) SAFARI Research Group at Carnegie Mellon University and ETH Zurich
+# Released under the MIT License
+
+import csv
+import glob
+import os
+import helper as hp
+
+# A trace read with -directIO must be estimated as the same trace read through the page cache, whichever engine reads
+# its blocks and whether or not it is compressed
+def test_direct_io(trace_f, data_model, parser, name, extra_args):
+    plain_csv = trace_f + ".plain.csv"
+    direct_csv = trace_f + ".direct.csv"
+    status = 0
+
+    hp.vampire(trace_f, csv_f=plain_csv, data_model=data_model, parser=parser, extra_args=extra_args)
+    if hp.vampire(trace_f, csv_f=direct_csv, data_model=data_model, parser=parser,
+                  extra_args="-directIO " + extra_args) != 0:
+        status = 1
+    try:
+        hp.compare_csv([csv.reader(open(f), delimiter=',') for f in [plain_csv, direct_csv]])
+    except (ValueError, IOError):
+        status = 1
+
+    print "[test_direct_io]: Test " + os.path.basename(trace_f) + " " + parser + " " + name + " " \
+          + ["passed", "failed"][status]
+    for f in [plain_csv, direct_csv]:
+        if os.path.isfile(f):
+            os.remove(f)
+    return status
+
+def main():
+    hp.setup()
+    tests_status = []
+
+    for trace_f in sorted(glob.glob(hp.VAMPIRE_DIR + "/tests/traces/parser/0-*.trace")):
+        data_model = os.path.basename(trace_f).split("-")[1].split(".")[0].upper()
+        bin_f = trace_f + ".bin"
+        hp.convert_trace(trace_f, bin_f, data_model=data_model)
+        gzip_f = hp.compress_gzip(bin_f)
+
+        tests_status.append(test_direct_io(trace_f, data_model, "ASCII", "plain", ""))
+        tests_status.append(test_direct_io(trace_f, data_model, "ASCII", "parseThreads", "-parseThreads 2"))
+        tests_status.append(test_direct_io(bin_f, data_model, "BINARY", "plain", ""))
+        tests_status.append(test_direct_io(gzip_f, data_model, "BINARY", "gzip", ""))
+        for f in [bin_f, gzip_f]:
+            os.remove(f)
+
+    pass_count = tests_status.count(0)
+    print "[test_direct_io]: %d test completed, %d%% passed" \
+          % (len(tests_status), pass_count * 100 / max(len(tests_status), 1))
+    return 0 if pass_count == len(tests_status) else 1
+
+exit(main())
@@ -0,0 +1,128 @@
+#!/usr/bin/env python2
+
+# test_import.py
+
+# VAMPIRE: Variation-Aware model of Memory Power Informed by Real Experiments
+# https://github.com/CMU-SAFARI/VAMPIRE
+
+# Copyright (c) SAFARI Research Group at Carnegie Mellon University and ETH Zurich
+# Released under the MIT License
+
+import csv
+import glob
+import os
+import helper as hp
+
+def read_trace(trace_f):
+    return [line.split(",") for line in open(trace_f).read().split("\n") if line != ""]
+
+# Command traces of other simulators only hold the bank of ACT and RD/WR commands, every REF_INTERVAL commands a
+# refresh is added which VAMPIRE skips
+REF_INTERVAL = 100
+
+def to_ramulator(cmds):
+    lines = []
+    for pos, cmd in enumerate(cmds):
+        if pos % REF_INTERVAL == 0:
+            lines.append("%s,REF" % cmd[0])
+        lines.append("%s,%s,%s" % (cmd[0], cmd[1], cmd[2]))
+    return lines
+
+def to_drampower(cmds):
+    lines = ["# DRAMPower command trace"]
+    for pos, cmd in enumerate(cmds):
+        if pos % REF_INTERVAL == 0:
+            lines += ["%s,REF,0" % cmd[0], "%s,NOP,0" % cmd[0]]
+        lines.append("%s,%s,%s" % (cmd[0], cmd[1], cmd[2]))
+    return lines
+
+def to_dramsim3(cmds):
+    lines = []
+    for pos, cmd in enumerate(cmds):
+        bank = int(cmd[2])
+        row = int(cmd[3]) if cmd[1] == "ACT" else 0
+        col = int(cmd[3]) if cmd[1] != "ACT" and len(cmd) > 3 else 0
+        if pos % REF_INTERVAL == 0:
+            lines.append("%-10s %-18s 0 0 0 0 0x0 0x0" % (cmd[0], "refresh"))
+        lines.append("%-10s %-18s 0 0 %d %d %s %s" % (cmd[0], hp.DRAMSIM3_NAMES[cmd[1]], bank / hp.DRAMSIM3_BANKS_PER_GROUP,
+                                                      bank % hp.DRAMSIM3_BANKS_PER_GROUP, hex(row), hex(col)))
+    return lines
+
+# The reference of traces without rows and columns is the ASCII trace with every row and column set to 0
+def strip_address(cmds):
+    return [cmd[:3] + ["0"] * (len(cmd) > 3) for cmd in cmds]
+
+# Every few rounds of ACTs and RDs the banks are closed with a PREA, which VAMPIRE expands into PREs in the order the
+# banks were opened
+def prea_traces():
+    prea, pre = [], []
+    time = 1
+    for round in range(200):
+        banks = [(round * 3 + bank) % 8 for bank in range(1 + round % 4)]
+        for bank in banks:
+            for trace in [prea, pre]:
+                trace.append("%d,ACT,%d" % (time, bank))
+            time += 5
+            for trace in [prea, pre]:
+                trace.append("%d,RD,%d" % (time, bank))
+            time += 5
+        prea.append("%d,PREA" % time)
+        pre += ["%d,PRE,%d" % (time, bank) for bank in banks]
+        time += 20
+    return prea, [line + (",0" if ",PRE," not in line else "") for line in pre]
+
+def run_compare(name, import_f, parser, ref_f, data_model):
+    import_csv = import_f + ".csv"
+    ref_csv = ref_f + ".csv"
+    status = 0
+
+    hp.vampire(ref_f, csv_f=ref_csv, data_model=data_model, parser="ASCII")
+    if hp.vampire(import_f, csv_f=import_csv, data_model=data_model, parser=parser) != 0:
+        status = 1
+    try:
+        hp.compare_csv([csv.reader(open(f), delimiter=',') for f in [ref_csv, import_csv]])
+    except (ValueError, IOError):
+        status = 1
+
+    print "[test_import]: Test " + name + " " + parser + " " + ["passed", "failed"][status]
+    for f in [import_csv, ref_csv]:
+        if os.path.isfile(f):
+            os.remove(f)
+    return status
+
+def main():
+    hp.setup()
+    tests_status = []
+
+    for trace_f in sorted(glob.glob(hp.VAMPIRE_DIR + "/tests/traces/parser/0-*.trace")):
+        data_model = os.path.basename(trace_f).split("-")[1].split(".")[0].upper()
+        if data_model not in ["MEAN", "DIST"]:
+            continue
+        cmds = read_trace(trace_f)
+        stripped_f = trace_f + ".stripped"
+        hp.write_trace(stripped_f, [",".join(cmd) for cmd in strip_address(cmds)])
+
+        for parser, convert, ref_f in [("RAMULATOR", to_ramulator, stripped_f), ("DRAMPOWER", to_drampower, stripped_f),
+                                       ("DRAMSIM3", to_dramsim3, trace_f)]:
+            import_f = trace_f + "." + parser.lower()
+            hp.write_trace(import_f, convert(cmds))
+            tests_status.append(run_compare(os.path.basename(trace_f), import_f, parser, ref_f, data_model))
+            os.remove(import_f)
+        os.remove(stripped_f)
+
+    prea, pre = prea_traces()
+    prea_f = hp.VAMPIRE_DIR + "/tests/traces/parser/prea.trace.import"
+    pre_f = hp.VAMPIRE_DIR + "/tests/traces/parser/prea.trace.ref"
+    hp.write_trace(pre_f, pre)
+    for parser in ["RAMULATOR", "DRAMPOWER"]:
+        hp.write_trace(prea_f, [line + (",0" if parser == "DRAMPOWER" and line.endswith("PREA") else "") for line in prea])
+        tests_status.append(run_compare("PREA", prea_f, parser, pre_f, "MEAN"))
+    for f in [prea_f, pre_f]:
+        os.remove(f)
+
+    pass_count = tests_status.count(0)
+    print "[test_import]: %d test completed, %d%% passed" \
+          % (len(tests_status), pass_count * 100 / max(len(tests_status), 1))
+    return 0 if pass_count == len(tests_status) else 1
+
+exit(main())
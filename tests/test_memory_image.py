@@ -0,0 +1,150 @@
+#!/usr/bin/env python2
+
+# test_memory_image.py
+
+# VAMPIRE: Variation-Aware model of Memory Power Informed by Real Experiments
+# https://github.com/CMU-SAFARI/VAMPIRE
+
+# Copyright (c) SAFARI Research Group at Carnegie Mellon University and ETH Zurich
+# Released under the MIT License
+
+import csv
+import random
+import sys
+import os
+import helper as hp
+
+# Options selecting each backing store, the limit of the last one only holds a couple of rows and forces spilling
+MEM_IMAGES = ["-memImage SPARSE", "-memImage FLAT", "-memImage DEDUP", "-memImage COMPRESSED",
+              "-memImage SPARSE -memLimit 20K"]
+
+# WRs of ASCII traces do not hold their row, each bank holds one row of the generated trace. The banks are opened at row
+# 0 so that RDs read the lines written there
+WR_BANKS = 64       # Far more rows than the 20K limit holds
+WR_VISITS = 240     # Times a row is opened, rows are revisited after they were spilled
+
+# Data of a line of each class of the COMPRESSED backing store, as written to an ASCII trace. Shared lines are drawn from
+# a few random lines, so that DEDUP stores them once
+def line_data(rng, line_class, shared):
+    if line_class == "shared":
+        return rng.choice(shared)
+    elif line_class == "zero":
+        words = [0] * 16
+    elif line_class == "repeat":
+        words = [rng.randint(1, 0xFFFFFFFF)] * 16
+    elif line_class == "bdi":
+        base = rng.randint(0x100, 0xFFFFFEFF)
+        words = [base] + [(base + rng.randint(-128, 127)) & 0xFFFFFFFF for _ in range(15)]
+    else:
+        words = [rng.randint(0, 0xFFFFFFFF) for _ in range(16)]
+    return "".join("%08x" % word for word in words)
+
+# WR trace mixing zero, repeated-word, BDI compressible and random lines over many rows, with RDs of written lines and
+# overwrites that change the class of a line
+def write_wr_trace(trace_f):
+    rng = random.Random(5)
+    shared = [line_data(rng, rng.choice(["bdi", "raw"]), []) for _ in range(6)]
+    lines = []
+    written = {}
+    time = 1
+
+    for _ in range(WR_VISITS):
+        bank = rng.randint(0, WR_BANKS - 1)
+        cols = written.setdefault(bank, [])
+        lines.append("%d,ACT,%d,0" % (time, bank))
+        time += 20
+
+        for _ in range(12):
+            if cols and rng.random() < 0.3:
+                lines.append("%d,RD,%d,%d" % (time, bank, rng.choice(cols)))
+            else:
+                # Overwrite a written line about half of the time, most likely with a line of another class
+                col = rng.choice(cols) if cols and rng.random() < 0.5 else rng.randint(0, 127)
+                line_class = rng.choice(["zero", "repeat", "bdi", "raw", "shared"])
+                lines.append("%d,WR,%d,%d,%s" % (time, bank, col, line_data(rng, line_class, shared)))
+                if col not in cols:
+                    cols.append(col)
+            time += 20
+
+        lines.append("%d,PRE,%d" % (time, bank))
+        time += 20
+
+    hp.write_trace(trace_f, lines)
+
+# Every backing store of the WR model should produce the same results
+def test_backends(trace_f, config_f):
+    tests_status = [0] * len(MEM_IMAGES)
+    csv_files = []
+
+    for mem_image_id, mem_image in enumerate(MEM_IMAGES):
+        csv_f = trace_f + "." + str(mem_image_id) + ".csv"
+        if hp.vampire(trace_f, config=config_f, csv_f=csv_f, data_model="WR", extra_args=mem_image) != 0:
+            tests_status[mem_image_id] = 1
+        csv_files.append(csv_f)
+
+    try:
+        hp.compare_csv([csv.reader(open(f), delimiter=',') for f in csv_files])
+    except (ValueError, IOError):
+        tests_status = [1] * len(MEM_IMAGES)
+
+    for mem_image_id, mem_image in enumerate(MEM_IMAGES):
+        print "[test_memory_image]: Test backend '" + mem_image + "' " + ["passed", "failed"][tests_status[mem_image_id]]
+
+    for csv_f in csv_files:
+        if os.path.isfile(csv_f):
+            os.remove(csv_f)
+
+    return tests_status
+
+# Running the two halves of a trace, passing the snapshot from the first to the second, should leave the same memory
+# contents as running the whole trace
+def test_snapshot(trace_f, config_f):
+    tests_status = [0] * len(MEM_IMAGES)
+    lines = open(trace_f).readlines()
+    first_half_f, second_half_f = trace_f + ".first", trace_f + ".second"
+    open(first_half_f, "w").writelines(lines[:len(lines) / 2])
+    open(second_half_f, "w").writelines(lines[len(lines) / 2:])
+
+    for mem_image_id, mem_image in enumerate(MEM_IMAGES):
+        full_img, first_img, second_img = [trace_f + "." + name + ".img" for name in ["full", "first", "second"]]
+        args = mem_image
+
+        status = hp.vampire(trace_f, config=config_f, data_model="WR", extra_args=args + " -memImageOut " + full_img)
+        status |= hp.vampire(first_half_f, config=config_f, data_model="WR",
+                             extra_args=args + " -memImageOut " + first_img)
+        status |= hp.vampire(second_half_f, config=config_f, data_model="WR",
+                             extra_args=args + " -memImageIn " + first_img + " -memImageOut " + second_img)
+        if status != 0 or hp.exec_shell("cmp -s %s %s" % (full_img, second_img))[0] != 0:
+            tests_status[mem_image_id] = 1
+
+        print "[test_memory_image]: Test snapshot '" + mem_image + "' " + ["passed", "failed"][tests_status[mem_image_id]]
+
+        for img in [full_img, first_img, second_img]:
+            if os.path.isfile(img):
+                os.remove(img)
+
+    os.remove(first_half_f)
+    os.remove(second_half_f)
+    return tests_status
+
+def main():
+    hp.setup()
+    trace_f = hp.VAMPIRE_DIR + "/tests/traces/memory_image.trace"
+    config_f = hp.VAMPIRE_DIR + "/tests/configs/memory_image.cfg"
+    write_wr_trace(trace_f)
+    hp.write_config(config_f, numBanks=WR_BANKS, numRows=1024)
+
+    tests_status = test_backends(trace_f, config_f) + test_snapshot(trace_f, config_f)
+    os.remove(trace_f)
+    os.remove(config_f)
+    pass_count = tests_status.count(0)
+
+    print "[test_memory_image]: Result:"
+    for status in tests_status:
+        sys.stdout.write(["o", "x"][status])
+    print ""
+    print "[test_memory_image]: %d test completed, %d%% passed" % (len(tests_status), pass_count * 100 / len(tests_status))
+
+    return 0 if pass_count == len(tests_status) else 1
+
+sys.exit(main())
@@ -0,0 +1,90 @@
+#!/usr/bin/env python2
+
+# test_multi_rank.py
+
+# VAMPIRE: Variation-Aware model of Memory Power Informed by Real Experiments
+# https://github.com/CMU-SAFARI/VAMPIRE
+
+# Copyright (c) SAFARI Research Group at Carnegie Mellon University and ETH Zurich
+# Released under the MIT License
+
+import csv
+import glob
+import os
+import helper as hp
+
+# The same commands issued to the same banks of two ranks must not share the state of their banks: selecting one of
+# the ranks estimates the trace of a single rank
+def test_rank_select(name, single_f, multi_f, config_f, data_model):
+    single_csv = single_f + ".csv"
+    multi_csv = multi_f + ".csv"
+    status = 0
+
+    hp.vampire(single_f, csv_f=single_csv, data_model=data_model, parser="DRAMSIM3")
+    if hp.vampire(multi_f, config=config_f, csv_f=multi_csv, data_model=data_model, parser="DRAMSIM3",
+                  extra_args="-select chan=1,rank=1") != 0:
+        status = 1
+    try:
+        hp.compare_csv([csv.reader(open(f), delimiter=',') for f in [single_csv, multi_csv]])
+    except (ValueError, IOError):
+        status = 1
+
+    print "[test_multi_rank]: Test " + name + " rank select " + ["passed", "failed"][status]
+    for f in [single_csv, multi_csv]:
+        if os.path.isfile(f):
+            os.remove(f)
+    return status
+
+# Every rank of the configuration stands by as long as the single rank does, including the ranks without commands
+def test_standby(name, single_f, multi_f, config_f, data_model, rank_count):
+    single_csv = single_f + ".csv"
+    multi_csv = multi_f + ".csv"
+    status = 0
+
+    hp.vampire(single_f, csv_f=single_csv, data_model=data_model, parser="DRAMSIM3")
+    if hp.vampire(multi_f, config=config_f, csv_f=multi_csv, data_model=data_model, parser="DRAMSIM3") != 0:
+        status = 1
+    try:
+        cycles = [int(stats["totalActStandbyCycles"]) + int(stats["totalPreStandbyCycles"])
+                  for stats in [hp.read_csv(single_csv), hp.read_csv(multi_csv)]]
+        if cycles[1] != rank_count * cycles[0]:
+            status = 1
+    except (KeyError, ValueError, IOError):
+        status = 1
+
+    print "[test_multi_rank]: Test " + name + " standby " + ["passed", "failed"][status]
+    for f in [single_csv, multi_csv]:
+        if os.path.isfile(f):
+            os.remove(f)
+    return status
+
+def main():
+    hp.setup()
+    tests_status = []
+    config_f = hp.VAMPIRE_DIR + "/tests/configs/multi_rank.cfg"
+    hp.write_config(config_f, numChannels=2, numRanks=2)
+
+    for trace_f in sorted(glob.glob(hp.VAMPIRE_DIR + "/tests/traces/parser/0-*.trace")):
+        data_model = os.path.basename(trace_f).split("-")[1].split(".")[0].upper()
+        if data_model not in ["MEAN", "DIST"]:
+            continue
+        cmds = [line.split(",") for line in open(trace_f).read().split("\n") if line != ""]
+        single_f = trace_f + ".single"
+        multi_f = trace_f + ".multi"
+        # Ranks 0/0 and 1/1 receive the same commands at the same time, ranks 0/1 and 1/0 none
+        hp.write_trace(single_f, hp.by_time(hp.to_dramsim3(cmds, 0, 0)))
+        hp.write_trace(multi_f, hp.by_time(hp.to_dramsim3(cmds, 0, 0) + hp.to_dramsim3(cmds, 1, 1)))
+
+        name = os.path.basename(trace_f)
+        tests_status.append(test_rank_select(name, single_f, multi_f, config_f, data_model))
+        tests_status.append(test_standby(name, single_f, multi_f, config_f, data_model, 4))
+        for f in [single_f, multi_f]:
+            os.remove(f)
+    os.remove(config_f)
+
+    pass_count = tests_status.count(0)
+    print "[test_multi_rank]: %d test completed, %d%% passed" \
+          % (len(tests_status), pass_count * 100 / max(len(tests_status), 1))
+    return 0 if pass_count == len(tests_status) else 1
+
+exit(main())
@@ -0,0 +1,104 @@
+#!/usr/bin/env python2
+
+# test_parallel.py
+
+# VAMPIRE: Variation-Aware model of Memory Power Informed by Real Experiments
+# https://github.com/CMU-SAFARI/VAMPIRE
+
+# Copyright (c) SAFARI Research Group at Carnegie Mellon University and ETH Zurich
+# Released under the MIT License
+
+import csv
+import glob
+import os
+import helper as hp
+
+# Stats of the whole trace rather than sums over its partitions
+DERIVED_STATS = ["total energy", "avgPower", "avgCurrent", "totalCycleCount"]
+
+# Commands of channel 1 are the ones of channel 0 a few cycles later and on other banks
+def to_channel(cmds, channel, rank):
+    return hp.to_dramsim3(cmds, channel, rank, time_shift=7 * channel, bank_shift=3 * channel)
+
+def close(value, ref):
+    return abs(value - ref) <= 1e-4 * max(abs(ref), 1)
+
+# A trace of a single channel is estimated the same on its own thread
+def test_single_channel(trace_f, data_model, parser):
+    seq_csv = trace_f + ".seq.csv"
+    par_csv = trace_f + ".par.csv"
+    status = 0
+
+    hp.vampire(trace_f, csv_f=seq_csv, data_model=data_model, parser=parser)
+    if hp.vampire(trace_f, csv_f=par_csv, data_model=data_model, parser=parser, extra_args="-parallel chan") != 0:
+        status = 1
+    try:
+        hp.compare_csv([csv.reader(open(f), delimiter=',') for f in [seq_csv, par_csv]])
+    except (ValueError, IOError):
+        status = 1
+
+    print "[test_parallel]: Test " + os.path.basename(trace_f) + " " + parser + " single channel " \
+          + ["passed", "failed"][status]
+    for f in [seq_csv, par_csv]:
+        if os.path.isfile(f):
+            os.remove(f)
+    return status
+
+# The statistics of the partitions add up to the ones of the trace, each partition is estimated as -select would
+def test_partitions(name, multi_f, config_f, level, selections):
+    par_csv = multi_f + ".par.csv"
+    select_csvs = [multi_f + ".select%d.csv" % pos for pos in range(len(selections))]
+    status = 0
+
+    if hp.vampire(multi_f, config=config_f, csv_f=par_csv, data_model="MEAN", parser="DRAMSIM3",
+                  extra_args="-parallel " + level) != 0:
+        status = 1
+    for selection, select_csv in zip(selections, select_csvs):
+        hp.vampire(multi_f, config=config_f, csv_f=select_csv, data_model="MEAN", parser="DRAMSIM3",
+                   extra_args="-select " + selection)
+    try:
+        parts = [hp.read_csv(f) for f in select_csvs]
+        for stat, value in hp.read_csv(par_csv).items():
+            if stat in DERIVED_STATS:
+                continue
+            if not close(float(value), sum(float(part[stat]) for part in parts)):
+                status = 1
+    except (ValueError, IOError, KeyError):
+        status = 1
+
+    print "[test_parallel]: Test " + name + " '-parallel " + level + "' " + ["passed", "failed"][status]
+    for f in [par_csv] + select_csvs:
+        if os.path.isfile(f):
+            os.remove(f)
+    return status
+
+def main():
+    hp.setup()
+    tests_status = []
+    config_f = hp.VAMPIRE_DIR + "/tests/configs/parallel.cfg"
+    hp.write_config(config_f, numChannels=2, numRanks=2)
+
+    for trace_f in sorted(glob.glob(hp.VAMPIRE_DIR + "/tests/traces/parser/0-*.trace")):
+        data_model = os.path.basename(trace_f).split("-")[1].split(".")[0].upper()
+        if data_model != "DIST":
+            tests_status.append(test_single_channel(trace_f, data_model, "ASCII"))
+        if data_model != "MEAN":
+            continue
+
+        cmds = [line.split(",") for line in open(trace_f).read().split("\n") if line != ""]
+        multi_f = trace_f + ".multi"
+        hp.write_trace(multi_f, hp.by_time(to_channel(cmds, 0, 0) + to_channel(cmds, 1, 1)))
+
+        name = os.path.basename(trace_f)
+        tests_status.append(test_partitions(name, multi_f, config_f, "chan", ["chan=0", "chan=1"]))
+        tests_status.append(test_partitions(name, multi_f, config_f, "rank",
+                                            ["chan=%d,rank=%d" % (chan, rank) for chan in range(2) for rank in range(2)]))
+        os.remove(multi_f)
+    os.remove(config_f)
+
+    pass_count = tests_status.count(0)
+    print "[test_parallel]: %d test completed, %d%% passed" \
+          % (len(tests_status), pass_count * 100 / max(len(tests_status), 1))
+    return 0 if pass_count == len(tests_status) else 1
+
+exit(main())
@@ -0,0 +1,56 @@
+#!/usr/bin/env python2
+
+# test_parse_threads.py
+
+# VAMPIRE: Variation-Aware model of Memory Power Informed by Real Experiments
+# https://github.com/CMU-SAFARI/VAMPIRE
+
+# Copyright (c) SAFARI Research Group at Carnegie Mellon University and ETH Zurich
+# Released under the MIT License
+
+import csv
+import glob
+import os
+import helper as hp
+
+# Parsing options that should all produce the results of the sequential parser
+PARSE_OPTIONS = ["-parseThreads 1", "-parseThreads 3", "-parseThreads 2 -parseDepth 4"]
+
+def test_parse_threads(trace_f, data_model):
+    tests_status = []
+    plain_csv = trace_f + ".seq.csv"
+    hp.vampire(trace_f, csv_f=plain_csv, data_model=data_model)
+
+    for option_id, options in enumerate(PARSE_OPTIONS):
+        csv_f = trace_f + "." + str(option_id) + ".csv"
+        status = 0
+        if hp.vampire(trace_f, csv_f=csv_f, data_model=data_model, extra_args=options) != 0:
+            status = 1
+        try:
+            hp.compare_csv([csv.reader(open(f), delimiter=',') for f in [plain_csv, csv_f]])
+        except (ValueError, IOError):
+            status = 1
+
+        print "[test_parse_threads]: Test " + os.path.basename(trace_f) + " '" + options + "' " \
+              + ["passed", "failed"][status]
+        tests_status.append(status)
+        if os.path.isfile(csv_f):
+            os.remove(csv_f)
+
+    os.remove(plain_csv)
+    return tests_status
+
+def main():
+    hp.setup()
+    tests_status = []
+
+    for trace_f in sorted(glob.glob(hp.VAMPIRE_DIR + "/tests/traces/parser/0-*.trace")):
+        data_model = os.path.basename(trace_f).split("-")[1].split(".")[0].upper()
+        tests_status += test_parse_threads(trace_f, data_model)
+
+    pass_count = tests_status.count(0)
+    print "[test_parse_threads]: %d test completed, %d%% passed" \
+          % (len(tests_status), pass_count * 100 / max(len(tests_status), 1))
+    return 0 if pass_count == len(tests_status) else 1
+
+exit(main())
@@ -0,0 +1,80 @@
+#!/usr/bin/env python2
+
+# test_segments.py
+
+# VAMPIRE: Variation-Aware model of Memory Power Informed by Real Experiments
+# https://github.com/CMU-SAFARI/VAMPIRE
+
+# Copyright (c) SAFARI Research Group at Carnegie Mellon University and ETH Zurich
+# Released under the MIT License
+
+import csv
+import glob
+import os
+import helper as hp
+
+INDEX_INTERVAL = 97
+SEGMENT_COUNTS = [2, 7, 50]
+
+# The PRE closing a bank is folded into the last RD of its row, so that auto-precharges cross segment boundaries
+def to_autoprecharge(cmds):
+    out = []
+    last_rd = {}
+    for cmd in cmds:
+        if cmd[1] == "PRE" and cmd[2] in last_rd:
+            out[last_rd.pop(cmd[2])][1] = "RDA"
+            continue
+        if cmd[1] == "RD":
+            last_rd[cmd[2]] = len(out)
+        elif cmd[1] == "ACT":
+            last_rd.pop(cmd[2], None)
+        out.append(list(cmd))
+    return out
+
+# Segments estimated side by side add up to the estimate of the whole trace
+def test_segments(name, trace_f, data_model):
+    seq_csv = trace_f + ".seq.csv"
+    seg_csv = trace_f + ".seg.csv"
+    status = 0
+
+    hp.vampire(trace_f, csv_f=seq_csv, data_model=data_model,
+               extra_args="-buildIndex -indexInterval %d" % INDEX_INTERVAL)
+    for count in SEGMENT_COUNTS:
+        if hp.vampire(trace_f, csv_f=seg_csv, data_model=data_model, extra_args="-segments %d" % count) != 0:
+            status = 1
+        try:
+            hp.compare_csv([csv.reader(open(f), delimiter=',') for f in [seq_csv, seg_csv]])
+        except (ValueError, IOError):
+            status = 1
+
+    print "[test_segments]: Test " + name + " " + ["passed", "failed"][status]
+    for f in [seq_csv, seg_csv, trace_f + ".vidx"]:
+        if os.path.isfile(f):
+            os.remove(f)
+    return status
+
+def main():
+    hp.setup()
+    tests_status = []
+
+    for trace_f in sorted(glob.glob(hp.VAMPIRE_DIR + "/tests/traces/parser/0-*.trace")):
+        data_model = os.path.basename(trace_f).split("-")[1].split(".")[0].upper()
+        if data_model not in ["MEAN", "RD_WR"]:
+            continue
+        name = os.path.basename(trace_f)
+        tests_status.append(test_segments(name, trace_f, data_model))
+
+        if data_model != "MEAN":
+            continue
+        cmds = [line.split(",") for line in open(trace_f).read().split("\n") if line != ""]
+        autoprecharge_f = trace_f + ".autoprecharge"
+        hp.write_trace(autoprecharge_f, [",".join(cmd) for cmd in to_autoprecharge(cmds)])
+        tests_status.append(test_segments(name + " autoprecharge", autoprecharge_f, data_model))
+        os.remove(autoprecharge_f)
+
+    pass_count = tests_status.count(0)
+    print "[test_segments]: %d test completed, %d%% passed" \
+          % (len(tests_status), pass_count * 100 / max(len(tests_status), 1))
+    return 0 if pass_count == len(tests_status) else 1
+
+exit(main())
@@ -0,0 +1,123 @@
+#!/usr/bin/env python2
+
+# test_select.py
+
+# VAMPIRE: Variation-Aware model of Memory Power Informed by Real Experiments
+# https://github.com/CMU-SAFARI/VAMPIRE
+
+# Copyright (c) SAFARI Research Group at Carnegie Mellon University and ETH Zurich
+# Released under the MIT License
+
+import csv
+import glob
+import os
+import helper as hp
+
+# The commands selected by -select must be estimated as a trace made only of them. Banks that include the one of the last
+# command are selected so that the selected banks do not stand by longer than the filtered trace
+def test_select_banks(trace_f, data_model, parser, bin_convert, lines, banks):
+    first, last = banks
+    selection = "bank=%d-%d" % (first, last)
+    filtered_f = trace_f + ".filtered"
+    filtered_ascii_f = filtered_f + ".ascii"
+    select_csv = trace_f + ".select.csv"
+    filtered_csv = trace_f + ".filtered.csv"
+    status = 0
+
+    open(filtered_ascii_f, "w").write("".join(line for line in lines if first <= int(line.split(",")[2]) <= last))
+    if bin_convert:
+        hp.convert_trace(filtered_ascii_f, filtered_f, data_model=data_model)
+    else:
+        os.rename(filtered_ascii_f, filtered_f)
+
+    if hp.vampire(trace_f, csv_f=select_csv, data_model=data_model, parser=parser,
+                  extra_args="-select " + selection) != 0:
+        status = 1
+    hp.vampire(filtered_f, csv_f=filtered_csv, data_model=data_model, parser=parser)
+    try:
+        hp.compare_csv([csv.reader(open(f), delimiter=',') for f in [filtered_csv, select_csv]])
+    except (ValueError, IOError):
+        status = 1
+
+    print "[test_select]: Test " + os.path.basename(trace_f) + " " + parser + " '" + selection + "' " \
+          + ["passed", "failed"][status]
+    for f in [filtered_f, filtered_ascii_f, select_csv, filtered_csv]:
+        if os.path.isfile(f):
+            os.remove(f)
+    return status
+
+# Banks that are not selected still take time, the selected ones stand by until the last command of the trace
+def test_standby(trace_f, data_model, parser, lines):
+    last_bank = int(lines[-1].split(",")[2])
+    selection = "bank=%d" % ((last_bank + 1) % 8)
+    select_csv = trace_f + ".select.csv"
+    status = 0
+
+    if hp.vampire(trace_f, csv_f=select_csv, data_model=data_model, parser=parser,
+                  extra_args="-select " + selection) != 0:
+        status = 1
+    try:
+        stats = hp.read_csv(select_csv)
+        standby_cycles = int(stats["totalActStandbyCycles"]) + int(stats["totalPreStandbyCycles"])
+        if standby_cycles != int(lines[-1].split(",")[0]):
+            status = 1
+    except (KeyError, ValueError, IOError):
+        status = 1
+
+    print "[test_select]: Test " + os.path.basename(trace_f) + " " + parser + " '" + selection + "' standby " \
+          + ["passed", "failed"][status]
+    if os.path.isfile(select_csv):
+        os.remove(select_csv)
+    return status
+
+# A time range selects the same window as -from and -to
+def test_select_time(trace_f, data_model, parser, lines):
+    end_time = int(lines[-1].split(",")[0])
+    start, end = end_time / 3, 2 * end_time / 3
+    select_csv = trace_f + ".select.csv"
+    window_csv = trace_f + ".window.csv"
+    status = 0
+
+    if hp.vampire(trace_f, csv_f=select_csv, data_model=data_model, parser=parser,
+                  extra_args="-select time=%d:%d" % (start, end)) != 0:
+        status = 1
+    hp.vampire(trace_f, csv_f=window_csv, data_model=data_model, parser=parser,
+               extra_args="-from %d -to %d" % (start, end))
+    try:
+        hp.compare_csv([csv.reader(open(f), delimiter=',') for f in [window_csv, select_csv]])
+    except (ValueError, IOError):
+        status = 1
+
+    print "[test_select]: Test " + os.path.basename(trace_f) + " " + parser + " 'time=%d:%d' " % (start, end) \
+          + ["passed", "failed"][status]
+    for f in [select_csv, window_csv]:
+        if os.path.isfile(f):
+            os.remove(f)
+    return status
+
+def main():
+    hp.setup()
+    tests_status = []
+
+    for trace_f in sorted(glob.glob(hp.VAMPIRE_DIR + "/tests/traces/parser/0-*.trace")):
+        data_model = os.path.basename(trace_f).split("-")[1].split(".")[0].upper()
+        lines = open(trace_f).readlines()
+        last_bank = int(lines[-1].split(",")[2])
+        bin_f = trace_f + ".bin"
+        hp.convert_trace(trace_f, bin_f, data_model=data_model)
+
+        for banks in [(last_bank, last_bank), (last_bank / 4 * 4, last_bank / 4 * 4 + 3)]:
+            tests_status.append(test_select_banks(trace_f, data_model, "ASCII", False, lines, banks))
+            tests_status.append(test_select_banks(bin_f, data_model, "BINARY", True, lines, banks))
+        tests_status.append(test_standby(trace_f, data_model, "ASCII", lines))
+        tests_status.append(test_standby(bin_f, data_model, "BINARY", lines))
+        tests_status.append(test_select_time(trace_f, data_model, "ASCII", lines))
+        tests_status.append(test_select_time(bin_f, data_model, "BINARY", lines))
+        os.remove(bin_f)
+
+    pass_count = tests_status.count(0)
+    print "[test_select]: %d test completed, %d%% passed" \
+          % (len(tests_status), pass_count * 100 / max(len(tests_status), 1))
+    return 0 if pass_count == len(tests_status) else 1
+
+exit(main())
@@ -0,0 +1,105 @@
+#!/usr/bin/env python2
+
+# test_streaming.py
+
+# VAMPIRE: Variation-Aware model of Memory Power Informed by Real Experiments
+# https://github.com/CMU-SAFARI/VAMPIRE
+
+# Copyright (c) SAFARI Research Group at Carnegie Mellon University and ETH Zurich
+# Released under the MIT License
+
+import csv
+import glob
+import os
+import struct
+import subprocess
+import time
+import helper as hp
+
+TIMEOUT = 30                            # Seconds VAMPIRE may take to finish a streamed trace
+
+ASCII_END = "END\n"
+BINARY_END = struct.pack("<QQ", 0, 0b111 << 30)     # Version 1 command of the end-of-input type
+
+def vampire_args(trace_f, csv_f, data_model, parser, extra_args=[]):
+    return [hp.VAMPIRE_PATH, "-f", trace_f, "-c", hp.VAMPIRE_CFG, "-d", data_model, "-p", parser, "-csv", csv_f] \
+           + extra_args
+
+def wait(process):
+    for _ in range(TIMEOUT * 10):
+        if process.poll() is not None:
+            return process.returncode
+        time.sleep(0.1)
+    process.kill()
+    process.wait()
+    return 1
+
+# Streams the trace through a pipe that stays open after the end-of-input marker, VAMPIRE must end on the marker
+def run_stdin(trace, end, csv_f, data_model, parser):
+    process = subprocess.Popen(vampire_args("-", csv_f, data_model, parser), stdin=subprocess.PIPE,
+                               stdout=open(os.devnull, "w"))
+    process.stdin.write(trace + end + "trailing bytes are ignored")
+    process.stdin.flush()
+    status = wait(process)
+    process.stdin.close()
+    return status
+
+# Appends the trace to a followed file in two parts, then ends it with the end-of-input marker
+def run_follow(trace, end, csv_f, data_model, parser):
+    follow_f = csv_f + ".follow"
+    open(follow_f, "wb").close()
+    process = subprocess.Popen(vampire_args(follow_f, csv_f, data_model, parser, ["-follow"]),
+                               stdout=open(os.devnull, "w"))
+    with open(follow_f, "ab") as follow:
+        for part in [trace[:len(trace) / 2], trace[len(trace) / 2:] + end]:
+            time.sleep(0.2)
+            follow.write(part)
+            follow.flush()
+    status = wait(process)
+    os.remove(follow_f)
+    return status
+
+def test_streaming(trace_f, data_model, parser, end):
+    tests_status = []
+    plain_csv = trace_f + ".plain.csv"
+    trace = open(trace_f, "rb").read()
+    hp.vampire(trace_f, csv_f=plain_csv, data_model=data_model, parser=parser)
+
+    for name, run in [("stdin", run_stdin), ("follow", run_follow)]:
+        csv_f = trace_f + "." + name + ".csv"
+        status = 0
+        if run(trace, end, csv_f, data_model, parser) != 0:
+            status = 1
+        try:
+            hp.compare_csv([csv.reader(open(f), delimiter=',') for f in [plain_csv, csv_f]])
+        except (ValueError, IOError):
+            status = 1
+
+        print "[test_streaming]: Test " + os.path.basename(trace_f) + " " + parser + " " + name + " " \
+              + ["passed", "failed"][status]
+        tests_status.append(status)
+        if os.path.isfile(csv_f):
+            os.remove(csv_f)
+
+    os.remove(plain_csv)
+    return tests_status
+
+def main():
+    hp.setup()
+    tests_status = []
+
+    for trace_f in sorted(glob.glob(hp.VAMPIRE_DIR + "/tests/traces/parser/0-*.trace")):
+        data_model = os.path.basename(trace_f).split("-")[1].split(".")[0].upper()
+        bin_f = trace_f + ".bin"
+        hp.convert_trace(trace_f, bin_f, data_model=data_model)
+
+        tests_status += test_streaming(trace_f, data_model, "ASCII", ASCII_END)
+        tests_status += test_streaming(bin_f, data_model, "BINARY", BINARY_END)
+        os.remove(bin_f)
+
+    pass_count = tests_status.count(0)
+    print "[test_streaming]: %d test completed, %d%% passed" \
+          % (len(tests_status), pass_count * 100 / max(len(tests_status), 1))
+    return 0 if pass_count == len(tests_status) else 1
+
+exit(main())
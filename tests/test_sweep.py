@@ -0,0 +1,60 @@
+#!/usr/bin/env python2
+
+# test_sweep.py
+
+# VAMPIRE: Variation-Aware model of Memory Power Informed by Real Experiments
+# https://github.com/CMU-SAFARI/VAMPIRE
+
+# Copyright (c) SAFARI Research Group at Carnegie Mellon University and ETH Zurich
+# Released under the MIT License
+
+import csv
+import glob
+import os
+import helper as hp
+
+# (vendor, dramSpec, structural variation) of each configuration of the sweep
+CONFIGS = [("A", None, False), ("B", None, True), ("C", None, False), ("Cust", "/dramSpec/example.cfg", False)]
+
+def sweep_arg(config):
+    vendor, dramSpec, structVar = config
+    return vendor + (":" + hp.VAMPIRE_DIR + dramSpec if dramSpec else "") + (":s" if structVar else "")
+
+# Each configuration of a sweep is estimated as a run with its own -v, -dramSpec and -s would estimate it
+def test_sweep(trace_f, data_model):
+    sweep_csv = trace_f + ".sweep.csv"
+    config_csv = trace_f + ".config.csv"
+    status = 0
+
+    if hp.vampire(trace_f, csv_f=sweep_csv, data_model=data_model,
+                  extra_args="-sweep " + ",".join(sweep_arg(config) for config in CONFIGS)) != 0:
+        status = 1
+    for pos, (vendor, dramSpec, structVar) in enumerate(CONFIGS):
+        hp.vampire(trace_f, vendor=vendor, csv_f=config_csv, data_model=data_model,
+                   dramSpec=hp.VAMPIRE_DIR + dramSpec if dramSpec else None, extra_args="-s" if structVar else "")
+        try:
+            hp.compare_csv([csv.reader(open(f), delimiter=',')
+                            for f in [config_csv, trace_f + ".sweep.%d.csv" % pos]])
+        except (ValueError, IOError):
+            status = 1
+
+    print "[test_sweep]: Test " + os.path.basename(trace_f) + " " + ["passed", "failed"][status]
+    for f in [config_csv] + [trace_f + ".sweep.%d.csv" % pos for pos in range(len(CONFIGS))]:
+        if os.path.isfile(f):
+            os.remove(f)
+    return status
+
+def main():
+    hp.setup()
+    tests_status = []
+
+    for trace_f in sorted(glob.glob(hp.VAMPIRE_DIR + "/tests/traces/parser/0-*.trace")):
+        data_model = os.path.basename(trace_f).split("-")[1].split(".")[0].upper()
+        tests_status.append(test_sweep(trace_f, data_model))
+
+    pass_count = tests_status.count(0)
+    print "[test_sweep]: %d test completed, %d%% passed" \
+          % (len(tests_status), pass_count * 100 / max(len(tests_status), 1))
+    return 0 if pass_count == len(tests_status) else 1
+
+exit(main())
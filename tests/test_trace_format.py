@@ -0,0 +1,54 @@
+#!/usr/bin/env python2
+
+# test_trace_format.py
+
+# VAMPIRE: Variation-Aware model of Memory Power Informed by Real Experiments
+# https://github.com/CMU-SAFARI/VAMPIRE
+
+# Copyright (c) SAFARI Research Group at Carnegie Mellon University and ETH Zurich
+# Released under the MIT License
+
+import csv
+import glob
+import os
+import helper as hp
+
+# A trace converted to version 2 binary with -traceOut should give the results of the trace it was converted from
+def test_trace_format(trace_f, data_model, parser):
+    status = 0
+    src_csv, v2_csv, v2_f = trace_f + ".src.csv", trace_f + ".v2.csv", trace_f + ".v2"
+
+    status |= hp.vampire(trace_f, csv_f=src_csv, data_model=data_model, parser=parser, extra_args="-traceOut " + v2_f)
+    status |= hp.vampire(v2_f, csv_f=v2_csv, data_model=data_model, parser="BINARY")
+    try:
+        hp.compare_csv([csv.reader(open(f), delimiter=',') for f in [src_csv, v2_csv]])
+        if os.path.getsize(v2_f) >= os.path.getsize(trace_f):
+            status = 1
+    except (ValueError, IOError, OSError):
+        status = 1
+
+    print "[test_trace_format]: Test " + os.path.basename(trace_f) + " " + parser + " " + ["passed", "failed"][status != 0]
+    for f in [src_csv, v2_csv, v2_f]:
+        if os.path.isfile(f):
+            os.remove(f)
+    return int(status != 0)
+
+def main():
+    hp.setup()
+    tests_status = []
+
+    for trace_f in sorted(glob.glob(hp.VAMPIRE_DIR + "/tests/traces/parser/0-*.trace")):
+        data_model = os.path.basename(trace_f).split("-")[1].split(".")[0].upper()
+        bin_f = trace_f + ".bin"
+        hp.convert_trace(trace_f, bin_f, data_model=data_model)
+
+        tests_status.append(test_trace_format(trace_f, data_model, "ASCII"))
+        tests_status.append(test_trace_format(bin_f, data_model, "BINARY"))
+        os.remove(bin_f)
+
+    pass_count = tests_status.count(0)
+    print "[test_trace_format]: %d test completed, %d%% passed" \
+          % (len(tests_status), pass_count * 100 / max(len(tests_status), 1))
+    return 0 if pass_count == len(tests_status) else 1
+
+exit(main())
@@ -0,0 +1,76 @@
+#!/usr/bin/env python2
+
+# test_trace_index.py
+
+# VAMPIRE: Variation-Aware model of Memory Power Informed by Real Experiments
+# https://github.com/CMU-SAFARI/VAMPIRE
+
+# Copyright (c) SAFARI Research Group at Carnegie Mellon University and ETH Zurich
+# Released under the MIT License
+
+import csv
+import glob
+import os
+import helper as hp
+
+INDEX_INTERVAL = 100
+
+def last_issue_time(trace_f):
+    return int(open(trace_f).read().strip().split("\n")[-1].split(",")[0])
+
+# Windows estimated after seeking through the index must match the windows reached by parsing the whole trace
+def test_trace_index(trace_f, data_model, parser, end_time):
+    tests_status = []
+    index_f = trace_f + ".vidx"
+    windows = [(0, end_time), (end_time / 3, 2 * end_time / 3), (end_time / 2, end_time)]
+
+    for window_id, (start, end) in enumerate(windows):
+        window_args = "-from %d -to %d" % (start, end)
+        plain_csv = trace_f + ".plain.csv"
+        index_csv = trace_f + ".index.csv"
+        status = 0
+
+        if os.path.isfile(index_f):
+            os.remove(index_f)
+        if hp.vampire(trace_f, csv_f=plain_csv, data_model=data_model, parser=parser, extra_args=window_args) != 0:
+            status = 1
+        hp.vampire(trace_f, data_model=data_model, parser=parser,
+                   extra_args="-buildIndex -indexInterval %d" % INDEX_INTERVAL)
+        if not os.path.isfile(index_f):
+            status = 1
+        if hp.vampire(trace_f, csv_f=index_csv, data_model=data_model, parser=parser, extra_args=window_args) != 0:
+            status = 1
+        try:
+            hp.compare_csv([csv.reader(open(f), delimiter=',') for f in [plain_csv, index_csv]])
+        except (ValueError, IOError):
+            status = 1
+
+        print "[test_trace_index]: Test " + os.path.basename(trace_f) + " " + parser + " '" + window_args + "' " \
+              + ["passed", "failed"][status]
+        tests_status.append(status)
+        for f in [plain_csv, index_csv, index_f]:
+            if os.path.isfile(f):
+                os.remove(f)
+
+    return tests_status
+
+def main():
+    hp.setup()
+    tests_status = []
+
+    for trace_f in sorted(glob.glob(hp.VAMPIRE_DIR + "/tests/traces/parser/0-*.trace")):
+        data_model = os.path.basename(trace_f).split("-")[1].split(".")[0].upper()
+        end_time = last_issue_time(trace_f)
+        bin_f = trace_f + ".bin"
+        hp.convert_trace(trace_f, bin_f, data_model=data_model)
+
+        tests_status += test_trace_index(trace_f, data_model, "ASCII", end_time)
+        tests_status += test_trace_index(bin_f, data_model, "BINARY", end_time)
+        os.remove(bin_f)
+
+    pass_count = tests_status.count(0)
+    print "[test_trace_index]: %d test completed, %d%% passed" \
+          % (len(tests_status), pass_count * 100 / max(len(tests_status), 1))
+    return 0 if pass_count == len(tests_status) else 1
+
+exit(main())